@@ -0,0 +1,49 @@
+#include "adpcm.h"
+
+namespace {
+constexpr int8_t index_table[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                    -1, -1, -1, -1, 2, 4, 6, 8};
+
+constexpr int16_t step_table[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+} // namespace
+
+auto AdpcmDecoder::decode(uint8_t nibble) -> int16_t {
+  int32_t const step = step_table[step_index_];
+  int32_t diff = step >> 3;
+  if (nibble & 1)
+    diff += step >> 2;
+  if (nibble & 2)
+    diff += step >> 1;
+  if (nibble & 4)
+    diff += step;
+  predictor_ += (nibble & 8) ? -diff : diff;
+  if (predictor_ > 32767)
+    predictor_ = 32767;
+  else if (predictor_ < -32768)
+    predictor_ = -32768;
+
+  step_index_ += index_table[nibble];
+  if (step_index_ < 0)
+    step_index_ = 0;
+  else if (step_index_ > 88)
+    step_index_ = 88;
+  return predictor_;
+}
+
+auto AdpcmDecoder::decode(AdpcmClip const &clip, uint32_t first, int16_t *out,
+                          size_t count) -> void {
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t const n = first + i;
+    uint8_t const byte = clip.data[n >> 1];
+    out[i] = decode((n & 1) ? (byte >> 4) : (byte & 0x0f));
+  }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA-ADPCM, 4 bits per sample. Two samples per byte, the low nibble
+// first (as in IMA-ADPCM WAV files). Clips are one continuous stream that
+// starts with predictor 0 and step index 0 (see generate-audio-clips.py).
+
+struct AdpcmClip {
+  const uint8_t *data;
+  uint32_t samples;
+};
+
+class AdpcmDecoder {
+public:
+  AdpcmDecoder() = default;
+
+  auto reset() -> void {
+    predictor_ = 0;
+    step_index_ = 0;
+  }
+
+  auto decode(uint8_t nibble) -> int16_t;
+
+  // Decodes samples [first, first + count) of the clip into `out`. `first`
+  // must be where the previous call stopped (or 0 after reset()).
+  auto decode(AdpcmClip const &clip, uint32_t first, int16_t *out,
+              size_t count) -> void;
+
+private:
+  int32_t predictor_ = 0;
+  int8_t step_index_ = 0;
+};
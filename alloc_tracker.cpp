@@ -0,0 +1,107 @@
+#include "alloc_tracker.h"
+
+#include "pico/stdlib.h"
+
+#include <cstdlib>
+#include <malloc.h>
+
+#include "binary_log.h"
+
+AllocTracker alloc_tracker;
+
+namespace {
+const char *const SUBSYSTEM_NAMES[] = {"boot",    "input", "frame", "leds",
+                                       "display", "sound", "log"};
+static_assert(sizeof(SUBSYSTEM_NAMES) / sizeof(SUBSYSTEM_NAMES[0]) ==
+              static_cast<uint8_t>(AllocSubsystem::Count));
+} // namespace
+
+auto AllocTracker::seal() -> void {
+  sealed_ = true;
+  sealed_heap_ = heap_in_use();
+  frame_allocations_ = 0;
+}
+
+auto AllocTracker::on_alloc(size_t size) -> void {
+#ifdef HEAP_FREE
+  if (sealed_) {
+    panic("heap allocation of %u bytes in %s after boot",
+          static_cast<unsigned>(size),
+          SUBSYSTEM_NAMES[static_cast<uint8_t>(subsystem_)]);
+  }
+#endif
+  ++allocations_;
+  ++per_subsystem_[static_cast<uint8_t>(subsystem_)];
+  ++frame_allocations_;
+}
+
+auto AllocTracker::on_free() -> void { ++frees_; }
+
+auto AllocTracker::heap_in_use() const -> uint32_t {
+  return mallinfo().uordblks;
+}
+
+auto AllocTracker::end_frame() -> void {
+  if (!sealed_) {
+    return;
+  }
+  uint32_t const heap = heap_in_use();
+#ifdef HEAP_FREE
+  if (heap > sealed_heap_) {
+    panic("heap grew by %u bytes after boot",
+          static_cast<unsigned>(heap - sealed_heap_));
+  }
+#endif
+  if (frame_allocations_ > 0 || heap != sealed_heap_) {
+    LOG("HEAP %u allocations in frame, total input=%u frame=%u leds=%u "
+        "display=%u sound=%u log=%u, in use %d bytes since boot",
+        frame_allocations_, allocations(AllocSubsystem::Input),
+        allocations(AllocSubsystem::Frame), allocations(AllocSubsystem::Leds),
+        allocations(AllocSubsystem::Display),
+        allocations(AllocSubsystem::Sound), allocations(AllocSubsystem::Log),
+        static_cast<int32_t>(heap - sealed_heap_));
+    // Report growth only once.
+    sealed_heap_ = heap;
+  }
+  frame_allocations_ = 0;
+}
+
+//
+// Replaced allocation functions. The aligned variants of C++17 are not
+// replaced; nothing in the firmware uses over-aligned types.
+//
+
+auto operator new(size_t size) -> void * {
+  alloc_tracker.on_alloc(size);
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+auto operator new[](size_t size) -> void * { return operator new(size); }
+
+auto operator new(size_t size, std::nothrow_t const &) noexcept -> void * {
+  alloc_tracker.on_alloc(size);
+  return std::malloc(size ? size : 1);
+}
+
+auto operator new[](size_t size, std::nothrow_t const &tag) noexcept
+    -> void * {
+  return operator new(size, tag);
+}
+
+auto operator delete(void *p) noexcept -> void {
+  if (p) {
+    alloc_tracker.on_free();
+    std::free(p);
+  }
+}
+
+auto operator delete[](void *p) noexcept -> void { operator delete(p); }
+
+auto operator delete(void *p, size_t) noexcept -> void { operator delete(p); }
+
+auto operator delete[](void *p, size_t) noexcept -> void {
+  operator delete(p);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Counts heap allocations, per frame and per part of the main loop.
+//
+// operator new and delete are replaced (see alloc_tracker.cpp) and count
+// into the subsystem the main loop is in; C allocations (newlib's printf,
+// ...) show up as growth of the heap in use, taken from mallinfo(). Once
+// boot is over (seal()), every frame that allocates is logged.
+//
+// With BUSYBOARD_HEAP_FREE (HEAP_FREE), an allocation after boot panics
+// instead, so a unit that runs for weeks cannot fragment its heap.
+
+enum class AllocSubsystem : uint8_t {
+  Boot,
+  Input,
+  Frame,
+  Leds,
+  Display,
+  Sound,
+  Log,
+  Count
+};
+
+class AllocTracker {
+public:
+  constexpr AllocTracker() = default;
+
+  auto set_subsystem(AllocSubsystem subsystem) -> void {
+    subsystem_ = subsystem;
+  }
+
+  // Ends boot; from now on the steady state must not allocate.
+  auto seal() -> void;
+  // Logs the allocations of the frame, if any, and starts the next one.
+  auto end_frame() -> void;
+
+  auto on_alloc(size_t size) -> void;
+  auto on_free() -> void;
+
+  auto allocations() const -> uint32_t { return allocations_; }
+  auto frees() const -> uint32_t { return frees_; }
+  auto allocations(AllocSubsystem subsystem) const -> uint32_t {
+    return per_subsystem_[static_cast<uint8_t>(subsystem)];
+  }
+  // Bytes of heap in use, from mallinfo().
+  auto heap_in_use() const -> uint32_t;
+
+private:
+  AllocSubsystem subsystem_ = AllocSubsystem::Boot;
+  bool sealed_ = false;
+  uint32_t allocations_ = 0;
+  uint32_t frees_ = 0;
+  uint32_t per_subsystem_[static_cast<uint8_t>(AllocSubsystem::Count)] = {};
+  uint32_t frame_allocations_ = 0;
+  uint32_t sealed_heap_ = 0;
+};
+
+extern AllocTracker alloc_tracker;
+
+// Storage for an object that is constructed late (e.g. after the hardware
+// it talks to is set up) but must not live on the heap.
+template <typename T> class StaticInstance {
+public:
+  template <typename... Args> auto emplace(Args &&...args) -> T & {
+    instance_ = new (storage_) T(std::forward<Args>(args)...);
+    return *instance_;
+  }
+
+  auto operator->() const -> T * { return instance_; }
+  auto operator*() const -> T & { return *instance_; }
+
+private:
+  alignas(T) unsigned char storage_[sizeof(T)];
+  T *instance_ = nullptr;
+};
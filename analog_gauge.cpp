@@ -0,0 +1,57 @@
+#include "analog_gauge.h"
+
+#include <algorithm>
+
+#include "color.h"
+
+#define FPS 60
+
+namespace {
+constexpr int32_t FULL_SCALE = ANALOG_GAUGE_SWEEP_DEGREES * 12;
+constexpr int32_t SLEW_PER_FRAME = ANALOG_GAUGE_SLEW_DEG_PER_SEC * 12 / FPS;
+} // namespace
+
+auto AnalogGauge::init(uint8_t motor) -> void {
+  motor_ = motor;
+  driver_.reset(motor_, ANALOG_GAUGE_RESET_DIRECTION, ANALOG_GAUGE_HZ);
+  homing_ = true;
+  target_ = 0;
+}
+
+auto AnalogGauge::set_enabled(bool enabled) -> void { enabled_ = enabled; }
+
+auto AnalogGauge::calc_frame(uint8_t value, PicoLed::Color *strip_begin,
+                             uint8_t led_count) -> void {
+  if (homing_) {
+    if (driver_.moving(motor_)) {
+      std::fill(strip_begin, strip_begin + led_count,
+                PicoLed::RGBW(0, 0, 0, enabled_ ? 64 : 0));
+      return;
+    }
+    homing_ = false;
+  }
+
+  int32_t const goal = enabled_ ? value << 8 : 0;
+  // The shift floors, which already rounds a negative step away from zero.
+  int32_t const diff = goal - smoothed_;
+  int32_t const round = diff > 0 ? (1 << ANALOG_GAUGE_SMOOTHING_SHIFT) - 1 : 0;
+  smoothed_ += (diff + round) >> ANALOG_GAUGE_SMOOTHING_SHIFT;
+
+  int32_t const wanted = smoothed_ * FULL_SCALE / (255 << 8);
+  int32_t const target =
+      std::clamp(wanted, target_ - SLEW_PER_FRAME, target_ + SLEW_PER_FRAME);
+  if (target != target_) {
+    target_ = target;
+    driver_.step_to(motor_, -ANALOG_GAUGE_RESET_DIRECTION * target_ / 12.f,
+                    ANALOG_GAUGE_HZ);
+  }
+
+  if (!enabled_) {
+    std::fill(strip_begin, strip_begin + led_count, PicoLed::RGB(0, 0, 0));
+    return;
+  }
+  // Green at rest, red at full scale.
+  float const hue = 120.f * (FULL_SCALE - target_) / FULL_SCALE;
+  auto const [r, g, b] = hsv_to_rgb(hue, 1.f, 64);
+  std::fill(strip_begin, strip_begin + led_count, PicoLed::RGBW(r, g, b, 32));
+}
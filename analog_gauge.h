@@ -0,0 +1,57 @@
+#pragma once
+
+#include <PicoLed.hpp>
+#include <cstdint>
+
+#include "gauge_driver.h"
+
+// Needle angle at full scale, from the end stop.
+#define ANALOG_GAUGE_SWEEP_DEGREES 270
+// The end stop is found by turning into this direction, the scale runs the
+// other way.
+#define ANALOG_GAUGE_RESET_DIRECTION 1
+// Top speed of the motor in revolutions per second (0.4 is about the
+// fastest ramp of motion_profile.h).
+#define ANALOG_GAUGE_HZ 0.4f
+// The needle target moves by at most this much per second, a bit slower
+// than the motor, so that the needle follows without overshooting.
+#define ANALOG_GAUGE_SLEW_DEG_PER_SEC 120
+// The value moves by 1/2^shift of the remaining distance per frame
+// (rounded away from zero, so it ends up on the goal), i.e. gets within
+// 5% of a new value after about 23 frames.
+#define ANALOG_GAUGE_SMOOTHING_SHIFT 3
+
+enum class GaugeSource : uint8_t { Fader, DialNumber, FrameLoad };
+
+// Shows a value 0..255 on one gauge of a GaugeDriver and tints the meter
+// backlight from green to red along with the needle.
+//
+// calc_frame() never waits for the motor: it smooths the value, limits
+// how far the needle target moves per frame and hands the target to the
+// driver, whose alarm interrupt does the stepping. While the needle is
+// homed after init() the value is ignored.
+class AnalogGauge {
+public:
+  explicit AnalogGauge(GaugeDriver &driver) : driver_(driver) {}
+
+  // Call after GaugeDriver::init().
+  auto init(uint8_t motor) -> void;
+
+  auto set_enabled(bool) -> void;
+  auto set_source(GaugeSource source) -> void { source_ = source; }
+  auto source() const -> GaugeSource { return source_; }
+
+  auto calc_frame(uint8_t value, PicoLed::Color *strip_begin,
+                  uint8_t led_count) -> void;
+
+private:
+  GaugeDriver &driver_;
+  uint8_t motor_ = 0;
+  bool enabled_ = false;
+  bool homing_ = false;
+  GaugeSource source_ = GaugeSource::Fader;
+  // The smoothed value << 8.
+  int32_t smoothed_ = 0;
+  // Needle target in 1/12 degrees from the end stop.
+  int32_t target_ = 0;
+};
@@ -0,0 +1,65 @@
+#include "audio_mixer.h"
+
+#include <algorithm>
+
+#define AUDIO_MIXER_CHUNK 32
+
+auto AudioMixer::play(AdpcmClip const &clip, uint16_t volume) -> void {
+  Voice *voice = &voices_[0];
+  for (auto &v : voices_) {
+    if (!v.clip) {
+      voice = &v;
+      break;
+    }
+    if (v.started < voice->started)
+      voice = &v;
+  }
+  voice->clip = &clip;
+  voice->position = 0;
+  voice->volume = std::min<uint16_t>(volume, 256);
+  voice->started = ++started_;
+  voice->decoder.reset();
+}
+
+auto AudioMixer::stop() -> void {
+  for (auto &v : voices_) {
+    v.clip = nullptr;
+  }
+}
+
+auto AudioMixer::active_voices() const -> uint8_t {
+  uint8_t n = 0;
+  for (auto const &v : voices_) {
+    n += v.clip != nullptr;
+  }
+  return n;
+}
+
+auto AudioMixer::mix(int16_t *out, size_t count) -> void {
+  while (count > 0) {
+    size_t const n = std::min(count, static_cast<size_t>(AUDIO_MIXER_CHUNK));
+    int32_t acc[AUDIO_MIXER_CHUNK] = {};
+    int16_t pcm[AUDIO_MIXER_CHUNK];
+
+    for (auto &v : voices_) {
+      if (!v.clip)
+        continue;
+      size_t const left = v.clip->samples - v.position;
+      size_t const m = std::min(left, n);
+      v.decoder.decode(*v.clip, v.position, pcm, m);
+      for (size_t i = 0; i < m; ++i) {
+        acc[i] += (pcm[i] * v.volume) >> 8;
+      }
+      v.position += m;
+      if (v.position >= v.clip->samples)
+        v.clip = nullptr;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = std::clamp(acc[i], static_cast<int32_t>(-32768),
+                          static_cast<int32_t>(32767));
+    }
+    out += n;
+    count -= n;
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "adpcm.h"
+
+#define AUDIO_VOICES 4
+
+// Mixes up to AUDIO_VOICES ADPCM clips into one signed 16 bit stream.
+// Plain C++, so that it can be tested and benchmarked on the host (see
+// host/audio_bench.cpp).
+class AudioMixer {
+public:
+  AudioMixer() = default;
+
+  // Starts the clip on a free voice, or on the one that has played the
+  // longest if all are busy. `volume` is 0..256 (256 = full scale).
+  auto play(AdpcmClip const &clip, uint16_t volume) -> void;
+  auto stop() -> void;
+
+  // Writes `count` samples. Silence when no voice is active.
+  auto mix(int16_t *out, size_t count) -> void;
+
+  auto active_voices() const -> uint8_t;
+
+private:
+  struct Voice {
+    AdpcmClip const *clip = nullptr;
+    uint32_t position = 0;
+    uint16_t volume = 0;
+    uint32_t started = 0;
+    AdpcmDecoder decoder;
+  };
+
+  Voice voices_[AUDIO_VOICES];
+  uint32_t started_ = 0;
+};
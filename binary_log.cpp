@@ -0,0 +1,89 @@
+#include "binary_log.h"
+
+#include "hardware/sync.h"
+
+#include <algorithm>
+
+BinaryLog binary_log;
+
+namespace {
+auto record_words(uint32_t header) -> uint32_t {
+  return 2 + ((header >> 16) & 0xff);
+}
+} // namespace
+
+static_assert((LOG_RING_WORDS & (LOG_RING_WORDS - 1)) == 0,
+              "the ring indices wrap around");
+static_assert(LOG_CHUNK_WORDS >= 2 + LOG_MAX_ARGS);
+
+auto BinaryLog::push(const char *format, uint8_t argc, uint32_t const *args)
+    -> void {
+  // The formats live at address 0 of .log_fmt, see binary_log.h.
+  uint32_t const header =
+      (reinterpret_cast<uintptr_t>(format) & 0xffff) | (argc << 16);
+  uint32_t const now = time_us_32();
+
+  auto const irq = save_and_disable_interrupts();
+  uint32_t const head = head_;
+  if (LOG_RING_WORDS - (head - tail_) < 2u + argc) {
+    dropped_ = dropped_ + 1;
+  } else {
+    words_[head % LOG_RING_WORDS] = header;
+    words_[(head + 1) % LOG_RING_WORDS] = now;
+    for (uint8_t i = 0; i < argc; ++i) {
+      words_[(head + 2 + i) % LOG_RING_WORDS] = args[i];
+    }
+    head_ = head + 2 + argc;
+  }
+  restore_interrupts(irq);
+}
+
+auto BinaryLog::start_chunk() -> bool {
+  // head_ only moves by whole records.
+  uint32_t const head = head_;
+  uint32_t count = 0;
+  while (tail_ + count != head) {
+    uint32_t const size =
+        record_words(words_[(tail_ + count) % LOG_RING_WORDS]);
+    if (count + size > LOG_CHUNK_WORDS)
+      break;
+    count += size;
+  }
+
+  auto const irq = save_and_disable_interrupts();
+  uint16_t const dropped =
+      std::min(static_cast<uint32_t>(dropped_), static_cast<uint32_t>(0xffff));
+  dropped_ = dropped_ - dropped;
+  restore_interrupts(irq);
+  if (count == 0 && dropped == 0)
+    return false;
+
+  header_[0] = 'L';
+  header_[1] = 'O';
+  header_[2] = 'G';
+  header_[3] = '1';
+  header_[4] = count & 0xff;
+  header_[5] = count >> 8;
+  header_[6] = dropped & 0xff;
+  header_[7] = dropped >> 8;
+  header_sent_ = 0;
+  chunk_words_ = count;
+  return true;
+}
+
+auto BinaryLog::next_byte(uint8_t &byte) -> bool {
+  if (header_sent_ < sizeof(header_)) {
+    byte = header_[header_sent_++];
+    return true;
+  }
+  if (chunk_words_ == 0)
+    return false;
+  uint32_t const word = words_[tail_ % LOG_RING_WORDS];
+  byte = (word >> (8 * word_byte_)) & 0xff;
+  if (++word_byte_ == 4) {
+    word_byte_ = 0;
+    chunk_words_--;
+    tail_ = tail_ + 1;
+  }
+  return true;
+}
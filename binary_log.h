@@ -0,0 +1,114 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#include "serial_out.h"
+
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+// Deferred logging, decoded on the host by log-decode.py.
+//
+//   LOG("PHONE NUM %d", num);
+//
+// A call stores the format string's offset in the .log_fmt section, the
+// time and the raw arguments as 4 byte words in a ring buffer; nothing is
+// formatted on the board. The ring is a stream of serial_out.h and goes
+// out in binary chunks:
+//
+//   chunk  = "LOG1" | count:u16 | dropped:u16 | word*count
+//   record = format:u16 | argc:u8 | 0:u8 | time_us:u32 | arg:u32*argc
+//
+// All values are little endian. `dropped` counts records lost since the
+// previous chunk because the ring was full.
+//
+// The format strings are only kept in the ELF, not in flash. Supported
+// conversions are %d %i %u %x %X %c %f (a float argument) and %%, with
+// flags, width and precision. At most LOG_MAX_ARGS arguments; strings are
+// not supported. LOG() is safe to call from interrupts on core 0.
+
+#define LOG_RING_WORDS 512
+#define LOG_MAX_ARGS 10
+// Words per chunk, at most.
+#define LOG_CHUNK_WORDS 64
+
+#ifndef LOG_FORMAT_SECTION
+#if defined(__arm__)
+// "@" starts a comment for the ARM assembler and hides the flags GCC
+// appends, so the section is not allocated: it ends up in the ELF, at
+// address 0, but not in the image.
+#define LOG_FORMAT_SECTION __attribute__((section(".log_fmt,\"\",%progbits @")))
+#else
+#define LOG_FORMAT_SECTION __attribute__((section(".log_fmt")))
+#endif
+#endif
+
+#define LOG(format, ...)                                                       \
+  do {                                                                         \
+    LOG_FORMAT_SECTION static const char log_format_[] = format;               \
+    static_assert(log_detail::conversions(format) ==                           \
+                      std::tuple_size_v<decltype(std::make_tuple(              \
+                          __VA_ARGS__))>,                                      \
+                  "LOG arguments do not match the format");                    \
+    binary_log.write(log_format_, ##__VA_ARGS__);                              \
+  } while (0)
+
+namespace log_detail {
+constexpr auto conversions(const char *format) -> size_t {
+  size_t n = 0;
+  for (; *format; ++format) {
+    if (*format != '%')
+      continue;
+    if (format[1] == '%')
+      ++format;
+    else
+      ++n;
+  }
+  return n;
+}
+
+template <typename T> auto word(T value) -> uint32_t {
+  static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>,
+                "LOG only takes numbers");
+  if constexpr (std::is_floating_point_v<T>) {
+    float const f = value;
+    uint32_t w;
+    std::memcpy(&w, &f, sizeof(w));
+    return w;
+  } else {
+    return static_cast<uint32_t>(value);
+  }
+}
+} // namespace log_detail
+
+class BinaryLog : public ChunkStream {
+public:
+  BinaryLog() = default;
+
+  template <typename... Args>
+  auto write(const char *format, Args... args) -> void {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS);
+    uint32_t const words[] = {log_detail::word(args)..., 0};
+    push(format, sizeof...(Args), words);
+  }
+
+  auto start_chunk() -> bool override;
+  auto next_byte(uint8_t &byte) -> bool override;
+
+private:
+  auto push(const char *format, uint8_t argc, uint32_t const *args) -> void;
+
+  uint32_t words_[LOG_RING_WORDS];
+  volatile uint32_t head_ = 0;
+  volatile uint32_t tail_ = 0;
+  volatile uint32_t dropped_ = 0;
+
+  // The chunk being written.
+  uint8_t header_[8];
+  uint8_t header_sent_ = sizeof(header_);
+  uint16_t chunk_words_ = 0;
+  uint8_t word_byte_ = 0;
+};
+
+extern BinaryLog binary_log;
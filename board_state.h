@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "modes.h"
+
+// The fields of State: name, type, number of elements and initial value.
+#define STATE_FIELDS(X)                                                        \
+  X(buttons_8, uint8_t, 1, 0)                                                  \
+  X(fader_mode, FaderMode, 1, FaderMode::RGB)                                  \
+  X(arcade_mode, ArcadeMode, 1, ArcadeMode::Binary)                            \
+  X(toggle_upper_left, bool, 1, true)                                          \
+  X(double_switch, bool, 2, false)                                             \
+  X(double_toggle, bool, 2, false)                                             \
+  X(arcade_1_pressed, bool, 1, false)                                          \
+  X(faders, uint8_t, 4, 0)                                                     \
+  X(fader_adc, uint8_t, 1, 0)                                                  \
+  X(dial_in_progress, bool, 1, false)                                          \
+  X(phone_dialed_num, int8_t, 1, -1)                                           \
+  X(switch6, int8_t, 1, 0)                                                     \
+  X(scroll_dotmatrix, bool, 1, false)                                          \
+  /* Time of the last frame, 255 is MS_PER_FRAME. */                           \
+  X(frame_load, uint8_t, 1, 0)
+
+// The first dirty bit of every field; every element has its own bit.
+namespace state_bit {
+enum : uint8_t {
+#define X(name, type, count, init) name, name##_last_ = name + (count)-1,
+  STATE_FIELDS(X)
+#undef X
+  count
+};
+static_assert(count <= 32, "the dirty bits have to fit a word");
+} // namespace state_bit
+
+// The dirty bits of all elements of a field.
+namespace state_mask {
+#define X(name, type, count, init)                                             \
+  constexpr uint32_t name = ((1u << (count)) - 1) << state_bit::name;
+STATE_FIELDS(X)
+#undef X
+constexpr uint32_t all = state_bit::count == 32
+                             ? ~0u
+                             : (1u << (state_bit::count % 32)) - 1;
+} // namespace state_mask
+
+// The dirty bit of element `i` of a field, e.g.
+// state_element(state_bit::double_switch, 1).
+constexpr auto state_element(uint8_t first_bit, uint8_t i) -> uint32_t {
+  return 1u << (first_bit + i);
+}
+
+namespace detail {
+template <typename T, size_t N>
+constexpr auto filled(T value) -> std::array<T, N> {
+  std::array<T, N> a{};
+  for (auto &v : a) {
+    v = value;
+  }
+  return a;
+}
+} // namespace detail
+
+// The inputs and modes of the board.
+//
+// Every field is read with name(i) and written with set_name(value, i);
+// a write that changes an element sets its dirty bit. Once per frame the
+// main loop hands the dirty bits to the subscribers and clears them, so
+// that nothing has to compare against a copy of the last frame.
+class State {
+public:
+#define X(name, type, count, init)                                             \
+  auto name(uint8_t i = 0) const -> type { return name##_[i]; }                \
+  auto name##_all() const -> std::array<type, count> const & {                 \
+    return name##_;                                                            \
+  }                                                                            \
+  auto set_##name(type value, uint8_t i = 0) -> void {                         \
+    if (name##_[i] != value) {                                                 \
+      name##_[i] = value;                                                      \
+      dirty_ |= state_element(state_bit::name, i);                             \
+    }                                                                          \
+  }
+  STATE_FIELDS(X)
+#undef X
+
+  auto dirty() const -> uint32_t { return dirty_; }
+  auto changed(uint32_t mask) const -> bool { return dirty_ & mask; }
+  auto clear_dirty() -> void { dirty_ = 0; }
+
+  // Advanced by the frame timer, not tracked.
+  uint32_t tick = 0;
+
+private:
+#define X(name, type, count, init)                                             \
+  std::array<type, count> name##_ = detail::filled<type, count>(init);
+  STATE_FIELDS(X)
+#undef X
+
+  uint32_t dirty_ = 0;
+};
+
+// Called by the main loop when a field of `mask` changed since the last
+// frame.
+struct StateSubscription {
+  uint32_t mask;
+  void (*on_change)();
+};
@@ -0,0 +1,354 @@
+#!/usr/bin/env python3
+
+"""Record and analyze switch bounce captured by the firmware (see
+bounce_capture.h). Build the firmware with -DBUSYBOARD_BOUNCE_CAPTURE=ON
+(or -DARCADE_RGB_BUTTON_BOUNCE_CAPTURE=ON for the arcade_rgb_button part).
+
+  ./bounce-capture.py record /dev/ttyACM0 capture.bin
+  ./bounce-capture.py analyze capture.bin
+  ./bounce-capture.py analyze capture.bin --csv out/   # input for bounce.py
+
+Recording streams straight to disk and the analysis keeps a fixed-size
+histogram per input, so captures can run for hours.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+MAGIC = b"BNC1"
+HEADER = struct.Struct("<4sIHH")
+RECORD = struct.Struct("<I")
+
+# Keep in sync with bounce_estimator.h
+WINDOW_MIN_US = 500
+WINDOW_MAX_US = 64000
+WINDOW_MARGIN_US = 250
+MIN_SAMPLES = 8
+
+HIST_BIN_US = 10
+HIST_BINS = WINDOW_MAX_US // HIST_BIN_US + 1  # last bin collects overflow
+
+BUSYBOARD_NAMES = {
+    18: "phone dial: pulsed number",
+    22: "phone dial: dial in progress",
+    **{32 + i: f"arcade button {i}" for i in range(8)},
+    32 + 8: "fader mode RGB",
+    32 + 9: "fader mode HSV",
+    32 + 10: "fader mode effect",
+    **{32 + 11 + i: f"switch 6 levels, pin {i}" for i in range(5)},
+    48 + 0: "toggle upper left",
+    48 + 1: "double toggle 1",
+    48 + 2: "double toggle 0",
+    48 + 3: "double switch 0",
+    48 + 4: "double switch 1",
+    48 + 5: "arcade button 1 (phone)",
+}
+
+
+def source_name(source):
+    if source in BUSYBOARD_NAMES:
+        return f"{BUSYBOARD_NAMES[source]} ({source_id(source)})"
+    return source_id(source)
+
+
+def source_id(source):
+    if source < 32:
+        return f"gpio {source}"
+    device, pin = divmod(source - 32, 16)
+    return f"pcf8575 {device} pin {pin}"
+
+
+def read_chunks(f, block_size=1 << 16):
+    """Yields (time_us, dropped, [(time_us, source, level)]) with unwrapped
+    64-bit timestamps. Bytes outside of chunks (e.g. text printed by the
+    firmware) are skipped."""
+    buf = b""
+    header_time = None
+    header_low = 0
+    while True:
+        block = f.read(block_size)
+        if not block:
+            return
+        buf += block
+        while True:
+            start = buf.find(MAGIC)
+            if start < 0:
+                buf = buf[-(len(MAGIC) - 1) :]
+                break
+            if len(buf) - start < HEADER.size:
+                buf = buf[start:]
+                break
+            _, t, count, dropped = HEADER.unpack_from(buf, start)
+            end = start + HEADER.size + count * RECORD.size
+            if len(buf) < end:
+                buf = buf[start:]
+                break
+
+            if header_time is None:
+                header_time = t
+            else:
+                header_time += (t - header_low) % (1 << 32)
+            header_low = t
+
+            records = []
+            for i in range(count):
+                (r,) = RECORD.unpack_from(buf, start + HEADER.size + i * 4)
+                age = ((t & 0xFFFFFF) - (r >> 8)) % (1 << 24)
+                records.append((header_time - age, r & 0x7F, (r >> 7) & 1))
+            yield header_time, dropped, records
+            buf = buf[end:]
+
+
+def clamp_window(us):
+    return min(max(us, WINDOW_MIN_US), WINDOW_MAX_US)
+
+
+def div0(a, b):
+    """Integer division rounding towards zero like C++."""
+    q = abs(a) // b
+    return q if a >= 0 else -q
+
+
+class Estimator:
+    """BounceEstimator from bounce_estimator.cpp, with the same integer
+    arithmetic."""
+
+    def __init__(self, initial_window_us):
+        self.settled = 0
+        self.mean_us = 0
+        self.dev_us = 0
+        self.peak_us = 0
+        self.window_us = clamp_window(initial_window_us)
+
+    def window_ms(self):
+        return (self.window_us + 999) // 1000
+
+    def on_settled(self, bounce_us):
+        bounce_us = min(bounce_us, WINDOW_MAX_US)
+        if self.settled == 0:
+            self.mean_us = bounce_us
+            self.dev_us = bounce_us // 2
+        else:
+            err = bounce_us - self.mean_us
+            self.mean_us += div0(err, 8)
+            self.dev_us += div0(abs(err) - self.dev_us, 4)
+        self.peak_us = max(bounce_us, self.peak_us - self.peak_us // 32)
+        self.settled += 1
+        if self.settled >= MIN_SAMPLES:
+            bound = max(self.peak_us, self.mean_us + 4 * self.dev_us)
+            self.window_us = clamp_window(bound * 5 // 4 + WINDOW_MARGIN_US)
+
+    def on_late_bounce(self, gap_us):
+        self.peak_us = max(self.peak_us, self.window_us + gap_us)
+        self.window_us = max(
+            self.window_us,
+            clamp_window(self.peak_us * 5 // 4 + WINDOW_MARGIN_US),
+        )
+
+
+class Debouncer:
+    """Replays the edges of one input through Debounce from debounce.h, so
+    the window it ends up with is the one the firmware would pick."""
+
+    def __init__(self, initial_window_us):
+        self.estimator = Estimator(initial_window_us)
+        self.window_start = None
+        self.window_end = None
+        self.last_edge = None
+        self.settled = None
+
+    def edge(self, t):
+        if self.window_end is not None and t >= self.window_end:
+            self.finish()
+        if self.window_end is None:
+            window_us = self.estimator.window_us
+            if self.settled is not None and t - self.settled < window_us:
+                self.estimator.on_late_bounce(t - self.settled)
+            self.window_start = t
+            self.window_end = t + self.estimator.window_ms() * 1000
+        self.last_edge = t
+
+    def finish(self):
+        if self.window_end is None:
+            return
+        self.estimator.on_settled(self.last_edge - self.window_start)
+        self.settled = self.window_end
+        self.window_end = None
+
+
+class Input:
+    def __init__(self, quiet_us, initial_window_us):
+        self.quiet_us = quiet_us
+        self.debouncer = Debouncer(initial_window_us)
+        self.hist = [0] * HIST_BINS
+        self.events = 0
+        self.edges = 0
+        self.max_us = 0
+        self.sum_us = 0
+        self.group_start = None
+        self.group_last = None
+
+    def edge(self, t):
+        self.edges += 1
+        self.debouncer.edge(t)
+        if self.group_last is not None and t - self.group_last > self.quiet_us:
+            self.finish()
+        if self.group_start is None:
+            self.group_start = t
+        self.group_last = t
+
+    def finish(self):
+        if self.group_start is None:
+            return
+        bounce = self.group_last - self.group_start
+        self.hist[min(bounce // HIST_BIN_US, HIST_BINS - 1)] += 1
+        self.events += 1
+        self.max_us = max(self.max_us, bounce)
+        self.sum_us += bounce
+        self.group_start = None
+        self.group_last = None
+
+    def percentile(self, p):
+        target = p * self.events
+        acc = 0
+        for i, n in enumerate(self.hist):
+            acc += n
+            if acc >= target:
+                return (i + 1) * HIST_BIN_US
+        return WINDOW_MAX_US
+
+    def recommended_us(self):
+        return self.debouncer.estimator.window_us
+
+
+def record(args):
+    import serial
+
+    port = serial.Serial(args.port, args.baud, timeout=0.2)
+    total = 0
+    last_report = time.time()
+    with open(args.output, "ab") as out:
+        try:
+            while True:
+                data = port.read(4096)
+                if data:
+                    out.write(data)
+                    total += len(data)
+                if time.time() - last_report > 5:
+                    out.flush()
+                    print(f"{total} bytes recorded", file=sys.stderr)
+                    last_report = time.time()
+        except KeyboardInterrupt:
+            pass
+    print(f"{total} bytes written to {args.output}", file=sys.stderr)
+
+
+def analyze(args):
+    inputs = {}
+    dropped_total = 0
+    chunks = 0
+    csv_files = {}
+    if args.csv:
+        os.makedirs(args.csv, exist_ok=True)
+
+    with open(args.capture, "rb") as f:
+        for _, dropped, records in read_chunks(f):
+            chunks += 1
+            dropped_total += dropped
+            for t, source, level in records:
+                inp = inputs.get(source)
+                if inp is None:
+                    inp = inputs[source] = Input(
+                        args.quiet_ms * 1000, args.initial_ms * 1000
+                    )
+                inp.edge(t)
+                if args.csv:
+                    if source not in csv_files:
+                        name = source_id(source).replace(" ", "_")
+                        csv_files[source] = open(f"{args.csv}/{name}.csv", "w")
+                    csv_files[source].write(f"{t} {level}\n")
+
+    for f in csv_files.values():
+        f.close()
+    for inp in inputs.values():
+        inp.finish()
+        inp.debouncer.finish()
+
+    print(f"{chunks} chunks, {sum(i.edges for i in inputs.values())} edges")
+    if dropped_total:
+        print(f"WARNING: {dropped_total} records dropped by the firmware")
+    print()
+    print(
+        f"{'input':45s} {'events':>7s} {'mean':>7s} {'p50':>7s} {'p99':>7s} "
+        f"{'max':>7s} {'window':>7s}"
+    )
+    for source in sorted(inputs):
+        inp = inputs[source]
+        if inp.events == 0:
+            continue
+        mean = inp.sum_us / inp.events
+        print(
+            f"{source_name(source):45s} {inp.events:7d} {mean / 1000:7.2f} "
+            f"{inp.percentile(0.5) / 1000:7.2f} "
+            f"{inp.percentile(0.99) / 1000:7.2f} {inp.max_us / 1000:7.2f} "
+            f"{inp.recommended_us() / 1000:7.2f}"
+        )
+    print()
+    print(
+        "All times in msec. 'window' is where bounce_estimator.h ends up "
+        "after replaying the capture."
+    )
+
+    if args.plot:
+        from matplotlib import pyplot as plt
+
+        for source in sorted(inputs):
+            inp = inputs[source]
+            last = max((i for i, n in enumerate(inp.hist) if n), default=0)
+            xs = [i * HIST_BIN_US / 1000 for i in range(last + 1)]
+            plt.step(xs, inp.hist[: last + 1], where="post", label=source_id(source))
+        plt.xlabel("bounce length [msec]")
+        plt.ylabel("events")
+        plt.legend()
+        plt.show()
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("record", help="stream a capture from the serial port")
+    p.add_argument("port")
+    p.add_argument("output")
+    p.add_argument("--baud", type=int, default=115200)
+    p.set_defaults(func=record)
+
+    p = sub.add_parser("analyze", help="bounce statistics of a capture")
+    p.add_argument("capture")
+    p.add_argument(
+        "--quiet-ms",
+        type=float,
+        default=20,
+        help="silence that separates two switching events",
+    )
+    p.add_argument(
+        "--initial-ms",
+        type=int,
+        default=4,
+        help="debounce window the firmware starts with",
+    )
+    p.add_argument("--csv", help="write per input edge lists for bounce.py")
+    p.add_argument("--plot", action="store_true")
+    p.set_defaults(func=analyze)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
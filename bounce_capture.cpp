@@ -0,0 +1,101 @@
+#include "bounce_capture.h"
+
+#include "hardware/sync.h"
+
+#include <algorithm>
+
+BounceCapture bounce_capture;
+
+auto BounceCapture::push(uint32_t time_us, uint8_t source, bool level) -> void {
+  auto const irq = save_and_disable_interrupts();
+  if (head_ - tail_ >= BOUNCE_CAPTURE_RECORDS) {
+    dropped_ = dropped_ + 1;
+  } else {
+    records_[head_ % BOUNCE_CAPTURE_RECORDS] =
+        (time_us << 8) | (level ? 0x80 : 0) | (source & 0x7f);
+    head_ = head_ + 1;
+  }
+  restore_interrupts(irq);
+}
+
+auto BounceCapture::on_gpio_event(uint gpio, uint32_t events) -> void {
+  if (!(gpio_mask_ & (1u << gpio)))
+    return;
+  auto const now = time_us_32();
+  // Both edges may be latched if the pin bounced faster than the interrupt
+  // was serviced. Record them in the order they must have happened.
+  if ((events & GPIO_IRQ_EDGE_FALL) && (events & GPIO_IRQ_EDGE_RISE)) {
+    bool const level = gpio_get(gpio);
+    push(now, gpio, !level);
+    push(now, gpio, level);
+  } else if (events & GPIO_IRQ_EDGE_RISE) {
+    push(now, gpio, true);
+  } else if (events & GPIO_IRQ_EDGE_FALL) {
+    push(now, gpio, false);
+  }
+}
+
+auto BounceCapture::on_pcf8575_read(uint8_t device, uint16_t prev,
+                                    uint16_t state) -> void {
+  uint16_t const changed = (prev ^ state) & pcf8575_masks_[device];
+  if (!changed)
+    return;
+  auto const now = time_us_32();
+  for (uint8_t i = 0; i < 16; ++i) {
+    if (changed & (1 << i)) {
+      push(now, BOUNCE_CAPTURE_PCF8575_SOURCE(device, i), state & (1 << i));
+    }
+  }
+}
+
+auto BounceCapture::start_chunk() -> bool {
+  // Read the fill level first, so that every record of the chunk is older
+  // than its timestamp.
+  uint32_t const available = head_ - tail_;
+  auto const now = time_us_32();
+  if (available == 0 && dropped_ == 0 &&
+      now - last_chunk_us_ < BOUNCE_CAPTURE_HEARTBEAT_US)
+    return false;
+
+  uint16_t const count =
+      std::min(available, static_cast<uint32_t>(BOUNCE_CAPTURE_DRAIN_RECORDS));
+
+  auto const irq = save_and_disable_interrupts();
+  uint16_t const dropped =
+      std::min(static_cast<uint32_t>(dropped_), static_cast<uint32_t>(0xffff));
+  dropped_ = dropped_ - dropped;
+  restore_interrupts(irq);
+
+  header_[0] = 'B';
+  header_[1] = 'N';
+  header_[2] = 'C';
+  header_[3] = '1';
+  for (int i = 0; i < 4; ++i) {
+    header_[4 + i] = (now >> (8 * i)) & 0xff;
+  }
+  header_[8] = count & 0xff;
+  header_[9] = count >> 8;
+  header_[10] = dropped & 0xff;
+  header_[11] = dropped >> 8;
+  header_sent_ = 0;
+  chunk_records_ = count;
+  last_chunk_us_ = now;
+  return true;
+}
+
+auto BounceCapture::next_byte(uint8_t &byte) -> bool {
+  if (header_sent_ < sizeof(header_)) {
+    byte = header_[header_sent_++];
+    return true;
+  }
+  if (chunk_records_ == 0)
+    return false;
+  uint32_t const record = records_[tail_ % BOUNCE_CAPTURE_RECORDS];
+  byte = (record >> (8 * record_byte_)) & 0xff;
+  if (++record_byte_ == 4) {
+    record_byte_ = 0;
+    chunk_records_--;
+    tail_ = tail_ + 1;
+  }
+  return true;
+}
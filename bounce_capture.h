@@ -0,0 +1,73 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#include "serial_out.h"
+
+// Streams raw input edges to the host for bounce analysis (see
+// bounce-capture.py).
+//
+// Edges of the selected inputs are stored as 4 byte records in a ring
+// buffer, which is a stream of serial_out.h and goes out in binary chunks:
+//
+//   chunk  = "BNC1" | time_us:u32 | count:u16 | dropped:u16 | record*count
+//   record = time_us[23:0] << 8 | level << 7 | source
+//
+// All values are little endian. `time_us` in the chunk header is the time
+// the chunk was started; the host reconstructs the full record timestamps
+// from it. `dropped` counts records lost since the previous chunk because
+// the buffer was full. An empty chunk is sent once per second as a heartbeat.
+//
+// Sources 0..29 are GPIO pins, PCF8575 device d pin p is 32 + 16 * d + p.
+
+#ifndef BOUNCE_CAPTURE_RECORDS
+#ifdef BOUNCE_CAPTURE
+#define BOUNCE_CAPTURE_RECORDS 16384
+#else
+#define BOUNCE_CAPTURE_RECORDS 16
+#endif
+#endif
+#define BOUNCE_CAPTURE_DRAIN_RECORDS 32
+#define BOUNCE_CAPTURE_HEARTBEAT_US 1000000
+#define BOUNCE_CAPTURE_PCF8575_SOURCE(device, pin) (32 + 16 * (device) + (pin))
+
+class BounceCapture : public ChunkStream {
+public:
+  BounceCapture() = default;
+
+  auto select_gpio(uint8_t pin) -> void { gpio_mask_ |= (1u << pin); }
+  auto select_pcf8575(uint8_t device, uint16_t pins) -> void {
+    pcf8575_masks_[device] |= pins;
+  }
+  auto enabled() const -> bool {
+    return gpio_mask_ || pcf8575_masks_[0] || pcf8575_masks_[1];
+  }
+
+  // Safe to call from the GPIO interrupt.
+  auto on_gpio_event(uint gpio, uint32_t events) -> void;
+  auto on_pcf8575_read(uint8_t device, uint16_t prev, uint16_t state) -> void;
+
+  // Chunks of at most BOUNCE_CAPTURE_DRAIN_RECORDS records.
+  auto start_chunk() -> bool override;
+  auto next_byte(uint8_t &byte) -> bool override;
+
+private:
+  auto push(uint32_t time_us, uint8_t source, bool level) -> void;
+
+  uint32_t gpio_mask_ = 0;
+  uint16_t pcf8575_masks_[2] = {0, 0};
+
+  uint32_t records_[BOUNCE_CAPTURE_RECORDS];
+  volatile uint32_t head_ = 0;
+  volatile uint32_t tail_ = 0;
+  volatile uint32_t dropped_ = 0;
+  uint32_t last_chunk_us_ = 0;
+
+  // The chunk being written.
+  uint8_t header_[12];
+  uint8_t header_sent_ = sizeof(header_);
+  uint16_t chunk_records_ = 0;
+  uint8_t record_byte_ = 0;
+};
+
+extern BounceCapture bounce_capture;
@@ -0,0 +1,53 @@
+#include "bounce_estimator.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+auto clamp_window(uint32_t us) -> uint32_t {
+  return std::min(std::max(us, static_cast<uint32_t>(BOUNCE_WINDOW_MIN_US)),
+                  static_cast<uint32_t>(BOUNCE_WINDOW_MAX_US));
+}
+} // namespace
+
+BounceEstimator::BounceEstimator(uint32_t initial_window_us) {
+  stats_.window_us = clamp_window(initial_window_us);
+}
+
+auto BounceEstimator::on_settled(uint32_t bounce_us) -> void {
+  bounce_us = std::min(bounce_us, static_cast<uint32_t>(BOUNCE_WINDOW_MAX_US));
+
+  if (stats_.settled == 0) {
+    stats_.mean_us = bounce_us;
+    stats_.dev_us = bounce_us / 2;
+  } else {
+    // Same smoothing constants as TCP's RTT estimator (1/8 and 1/4).
+    int32_t const err = static_cast<int32_t>(bounce_us) -
+                        static_cast<int32_t>(stats_.mean_us);
+    stats_.mean_us += err / 8;
+    stats_.dev_us += (std::abs(err) - static_cast<int32_t>(stats_.dev_us)) / 4;
+  }
+  // The peak decays by ~3% per sample, so a single outlier is forgotten
+  // after roughly a hundred presses.
+  stats_.peak_us = std::max(bounce_us, stats_.peak_us - stats_.peak_us / 32);
+  stats_.last_us = bounce_us;
+  ++stats_.settled;
+
+  if (stats_.settled >= BOUNCE_MIN_SAMPLES)
+    update_window();
+}
+
+auto BounceEstimator::on_late_bounce(uint32_t gap_us) -> void {
+  // The input bounced for at least the whole window plus the gap.
+  ++stats_.late_bounces;
+  stats_.peak_us = std::max(stats_.peak_us, stats_.window_us + gap_us);
+  stats_.window_us =
+      std::max(stats_.window_us,
+               clamp_window(stats_.peak_us * 5 / 4 + BOUNCE_WINDOW_MARGIN_US));
+}
+
+auto BounceEstimator::update_window() -> void {
+  uint32_t const bound =
+      std::max(stats_.peak_us, stats_.mean_us + 4 * stats_.dev_us);
+  stats_.window_us = clamp_window(bound * 5 / 4 + BOUNCE_WINDOW_MARGIN_US);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+// Online estimation of the bounce length of a single input.
+//
+// Each time an input settles, the debouncer reports how long it bounced
+// (time from the first to the last edge inside the debounce window). If an
+// edge arrives shortly after the window was closed, the window was too short
+// and the debouncer reports a late bounce.
+//
+// From this, the estimator keeps a smoothed mean, mean deviation and a slowly
+// decaying peak, and derives the shortest window that still covers the
+// observed bounce with some margin. Until enough samples are collected the
+// initial window is kept.
+
+#define BOUNCE_WINDOW_MIN_US 500
+#define BOUNCE_WINDOW_MAX_US 64000
+#define BOUNCE_WINDOW_MARGIN_US 250
+#define BOUNCE_MIN_SAMPLES 8
+
+struct BounceStats {
+  uint32_t settled = 0;      // number of settled edges
+  uint32_t late_bounces = 0; // edges seen right after the window closed
+  uint32_t last_us = 0;      // bounce length of the last settled edge
+  uint32_t mean_us = 0;
+  uint32_t dev_us = 0;
+  uint32_t peak_us = 0;
+  uint32_t window_us = 0; // current debounce window
+};
+
+class BounceEstimator {
+public:
+  explicit BounceEstimator(uint32_t initial_window_us = 2000);
+
+  auto on_settled(uint32_t bounce_us) -> void;
+  auto on_late_bounce(uint32_t gap_us) -> void;
+
+  auto window_us() const -> uint32_t { return stats_.window_us; }
+  auto window_ms() const -> uint32_t { return (stats_.window_us + 999) / 1000; }
+  auto stats() const -> BounceStats const & { return stats_; }
+
+private:
+  auto update_window() -> void;
+
+  BounceStats stats_;
+};
@@ -3,27 +3,42 @@
 #include "pico/stdlib.h"
 #include <pico/stdlib.h>
 
-#include <bitset>
 #include <cstdlib>
 #include <cstring>
-#include <iostream>
 
 #include <PicoLed.hpp>
-#include <pico7219/pico7219.h>
 extern "C" {
 #include "ads1115.h"
 }
 
+#include "alloc_tracker.h"
+#include "analog_gauge.h"
 #include "arcade_buttons.h"
 #include "arcade_sounds.h"
+#include "binary_log.h"
+#include "board_state.h"
+#include "bounce_capture.h"
 #include "color.h"
 #include "debounce.h"
 #include "dfPlayerDriver.h"
 #include "dotmatrix.h"
+#include "dotmatrix_bitmaps.h"
 #include "fan_leds.h"
+#include "gauge_driver.h"
 #include "modes.h"
 #include "phone.h"
+#include "random.h"
+#include "serial_out.h"
+#ifdef PWM_AUDIO
+#include "audio_clips.h"
+#include "pwm_audio.h"
+#endif
+#include "scope.h"
+#include "scroller.h"
+#include "sound_arbiter.h"
+#include "sound_clip.h"
 #include "sound_game.h"
+#include "timer_wheel.h"
 
 // hardware ------------------------------------------------------------------
 // - Raspberry Pi Pico
@@ -38,7 +53,7 @@ extern "C" {
 // GP  3 - I2C1 SCL
 // GP  4 - data in for WS2812b: 3 WGRB (fader panel)
 // GP  5
-// GP  6
+// GP  6 - PWM audio out (slice 3 A) -> RC filter -> amplifier
 // GP  7
 // GP  8 - UART1 TX -> DF Player Mini
 // GP  9 - UART1 TX -> DF Player Mini
@@ -46,13 +61,13 @@ extern "C" {
 // GP 11 - SPI1 TX  -> Dot matrix DIN
 // GP 12 - <reserved for SPI1 RX?>
 // GP 13 - SPI1 CSn -> Dot matrix CS
-// GP 14
-// GP 15
+// GP 14 - VID28 analog meter pin 1 (PWM slice 7 A)
+// GP 15 - VID28 analog meter pin 2/3 (PWM slice 7 B)
 //
 // GP 16 - I2C0 SDA
 // GP 17 - I2C1 SDL
 // GP 18 - phone dial: pulsed number (brown cable)
-// GP 19
+// GP 19 - VID28 analog meter pin 4 (PWM slice 1 B)
 // GP 20 - data in for WS2812b: string of 8 arcade buttons and 6 LEDs in fan
 // GP 21 - fan PWM signal
 // GP 22 - phone dial: dial in progress (green cable)
@@ -75,6 +90,7 @@ extern "C" {
 #define IO_EXPAND_16_DEVICE_1_I2C_LANE i2c1
 #define IO_EXPAND_16_DEVICE_1_INTERRUPT_PIN 28
 #define IO_EXPAND_16_DEVICE_1_I2C_ADDRESS 0x20
+// Initial debounce window; each pin adapts it to its measured bounce.
 #define IO_EXPAND_16_DEVICE_1_DEBOUNCE_MSEC 2
 
 #define IO_EXPAND_16_DEVICE_2_I2C_LANE i2c0
@@ -104,6 +120,11 @@ static_assert(fader_led_format == analog_meter_led_format);
 constexpr auto fader_and_analog_meter_led_string_length =
     FADER_LED_LENGTH + ANALOG_METER_LED_LENGTH;
 
+// The gauge has to stay off the slices of the fan (2) and PWM audio (3).
+#define ANALOG_METER_GAUGE_PIN_1 14
+#define ANALOG_METER_GAUGE_PIN_2_3 15
+#define ANALOG_METER_GAUGE_PIN_4 19
+
 #define PHONE_LEDS_DIN_PIN 26
 #define PHONE_LEDS_LENGTH 9
 constexpr auto phone_led_format = PicoLed::FORMAT_WGRB;
@@ -111,23 +132,39 @@ constexpr auto phone_led_format = PicoLed::FORMAT_WGRB;
 #define PHONE_DIAL_IN_PROGRESS_PIN 22
 #define PHONE_DIAL_PULSED_NUMBER 18
 
-#define DOT_MATRIX_SPI_CHAN PicoSpiNum::PICO_SPI_1
+#define DOT_MATRIX_SPI_CHAN spi1
 #define DOT_MATRIX_SPI_SCK 10
 #define DOT_MATRIX_SPI_TX 11
 #define DOT_MATRIX_SPI_CS 13
-#define DOT_MATRIX_SPI_BAUDRATE 1500 * 1000
-#define DOT_MATRIX_CHAIN_LEN 4
+// The MAX7219 is specified up to 10 MHz; the SPI picks the closest
+// rate below (8.9 MHz at 125 MHz clk_peri).
+#define DOT_MATRIX_SPI_BAUDRATE 10000 * 1000
+// DOT_MATRIX_CHAIN_LEN: see dotmatrix.h
+#define DOT_MATRIX_SCROLL_COLUMNS_PER_SEC 12
+
+// Scope mode channels, selected with the 8 arcade buttons.
+#define SCOPE_CHANNEL_FADER_0 0 /* ..3 */
+#define SCOPE_CHANNEL_FRAME_TIME 4
+#define SCOPE_CHANNEL_DIAL_PULSE 5
+#define SCOPE_DIAL_PULSE_FULL_SCALE_US 100000
 
 #define DFPLAYER_UART 1
+#define DFPLAYER_INIT_TIMEOUT_MS 3000
 #define DFPLAYER_MINI_RX 8 /* GP 8 - TX (UART 1) */
 #define DFPLAYER_MINI_TX 9 /* GP 9 - RX (UART 1) */
 
+// Short clips (dial digits, button clicks) are played from flash via PWM
+// when built with BUSYBOARD_PWM_AUDIO, see pwm_audio.h.
+#define PWM_AUDIO_PIN 6
+#define PWM_AUDIO_CLICK_VOLUME 160
+
 #define ADC_I2C_ADDR 0x48
 #define ADC_I2C_PORT i2c1
 
 #define FPS 60
 #define MS_PER_FRAME 16
 #define ARCADE_1_COLOR_RETAIN_TIME_MS 9000
+#define DEBUG_BOUNCE_INTERVAL_FRAMES (10 * FPS)
 
 constexpr uint16_t fader_min_max[4][2]{
     {72, 19813}, {64, 19707}, {121, 19657}, {84, 19787}};
@@ -136,7 +173,8 @@ constexpr uint16_t fader_min_max[4][2]{
 // globals
 //----------------------------------------------------------------------------
 
-DfPlayerPico<DFPLAYER_UART, DFPLAYER_MINI_TX, DFPLAYER_MINI_RX> *dfp = nullptr;
+StaticInstance<DfPlayerPico<DFPLAYER_UART, DFPLAYER_MINI_TX, DFPLAYER_MINI_RX>>
+    dfp;
 
 Debounce_PCF8575 io16_dev1(IO_EXPAND_16_DEVICE_1_I2C_LANE,
                            IO_EXPAND_16_DEVICE_1_I2C_ADDRESS,
@@ -155,24 +193,6 @@ volatile bool io16_device1_changed = true;
 std::optional<uint16_t> io16_device1_prev_state;
 std::optional<uint16_t> io16_device2_prev_state;
 
-struct State {
-  uint8_t buttons_8 = 0;
-  uint32_t tick = 0;
-  FaderMode fader_mode = FaderMode::RGB;
-  ArcadeMode arcade_mode = ArcadeMode::Binary;
-  bool toggle_upper_left = true;
-  bool double_switch[2] = {false, false};
-  bool double_toggle[2] = {false, false};
-  bool arcade_1_pressed = false;
-  uint32_t arcade_1_pressed_since_ms = 0;
-  uint8_t faders[4] = {0, 0, 0, 0};
-  uint8_t fader_adc = 0;
-  bool dial_in_progress = false;
-  int8_t phone_dialed_num = -1;
-  int8_t switch6 = 0;
-  bool scroll_dotmatrix = false;
-};
-
 struct Leds {
   PicoLed::Color grb_led_string[grb_led_string_length];
   PicoLed::Color fader_analog_string[fader_and_analog_meter_led_string_length];
@@ -180,18 +200,29 @@ struct Leds {
 };
 
 State state;
-std::optional<State> prev_state;
 Leds leds;
 volatile bool frame_changed = true;
+volatile bool arcade_1_color_retained = false;
 
+DotMatrix dot_matrix(DOT_MATRIX_SPI_CHAN, DOT_MATRIX_SPI_BAUDRATE,
+                     DOT_MATRIX_SPI_TX, DOT_MATRIX_SPI_SCK, DOT_MATRIX_SPI_CS);
+Scroller scroller;
+Scope scope;
+SoundArbiter sound_arbiter;
 SoundGame sound_game;
 Phone phone;
 FanLEDs fan_leds;
+#ifdef PWM_AUDIO
+PwmAudio pwm_audio(PWM_AUDIO_PIN);
+#endif
 ArcadeButtons buttons8;
+GaugeDriver gauges;
+AnalogGauge analog_gauge(gauges);
 
 //----------------------------------------------------------------------------
 
 void gpio_interrupt(uint gpio, uint32_t events) {
+  bounce_capture.on_gpio_event(gpio, events);
   if (gpio == PHONE_DIAL_PULSED_NUMBER) {
     // phone_pulse.on_event(events);
   } else if (gpio == PHONE_DIAL_IN_PROGRESS_PIN) {
@@ -211,8 +242,8 @@ auto read_adc() -> void {
   uint16_t fader_raw;
   ads1115_read_adc(&fader_raw, &adc);
 
-  uint16_t const m = fader_min_max[state.fader_adc][0];
-  uint16_t const M = fader_min_max[state.fader_adc][1];
+  uint16_t const m = fader_min_max[state.fader_adc()][0];
+  uint16_t const M = fader_min_max[state.fader_adc()][1];
 
   // clip
   fader_raw = std::max(m, fader_raw);
@@ -221,45 +252,89 @@ auto read_adc() -> void {
   float f = fader_raw / static_cast<float>(M - m);
   uint8_t f8 = 255 - 255 * f;
 
-  state.faders[state.fader_adc] = f8;
+  state.set_faders(f8, state.fader_adc());
 
   // setup the ADC for next frame
-  state.fader_adc = state.tick % 4;
+  state.set_fader_adc(state.tick % 4);
   ads1115_set_operating_mode(ADS1115_MODE_CONTINUOUS, &adc);
-  ads1115_set_input_mux(channels[state.fader_adc], &adc);
+  ads1115_set_input_mux(channels[state.fader_adc()], &adc);
   ads1115_set_pga(ADS1115_PGA_4_096, &adc);
   ads1115_set_data_rate(ADS1115_RATE_860_SPS, &adc);
   ads1115_write_config(&adc);
 }
 
-auto calc_frame() -> void {
-  if (!prev_state.has_value() || prev_state->fader_mode != state.fader_mode) {
-    fan_leds.set_mode(state.fader_mode);
+// The analog meter shows the frame load in scope mode, the dialed number
+// while the phone is on and the fan speed otherwise.
+auto gauge_source() -> GaugeSource {
+  if (state.arcade_mode() == ArcadeMode::Scope) {
+    return GaugeSource::FrameLoad;
+  } else if (state.double_toggle(0)) {
+    return GaugeSource::DialNumber;
   }
-  if (!prev_state.has_value() ||
-      prev_state->toggle_upper_left != state.toggle_upper_left ||
-      prev_state->arcade_mode != state.arcade_mode) {
-    buttons8.set_enabled(state.toggle_upper_left);
+  return GaugeSource::Fader;
+}
+
+auto gauge_value(GaugeSource source) -> uint8_t {
+  switch (source) {
+  case GaugeSource::Fader:
+    return state.faders(0);
+  case GaugeSource::DialNumber:
+    return state.phone_dialed_num() > 0 ? state.phone_dialed_num() * 255 / 9
+                                        : 0;
+  case GaugeSource::FrameLoad:
+    return state.frame_load();
+  }
+  return 0;
+}
+
+// Who is told about which change of the state, once per frame.
+constexpr StateSubscription state_subscriptions[] = {
+    {state_mask::fader_mode, [] { fan_leds.set_mode(state.fader_mode()); }},
+    {state_mask::toggle_upper_left | state_mask::arcade_mode,
+     [] { buttons8.set_enabled(state.toggle_upper_left()); }},
+    {state_mask::toggle_upper_left,
+     [] {
+       if (state.arcade_mode() == ArcadeMode::SoundGame) {
+         sound_game.set_enabled(state.toggle_upper_left());
+       }
+     }},
+    {state_element(state_bit::double_switch, 0),
+     [] { fan_leds.set_enabled(state.double_switch(0)); }},
+    {state_element(state_bit::double_switch, 1),
+     [] { analog_gauge.set_enabled(state.double_switch(1)); }},
+    {state_element(state_bit::double_toggle, 0),
+     [] { phone.switch_on(state.double_toggle(0)); }},
+};
+
+auto notify_subscriptions(uint32_t changed) -> void {
+  for (auto const &s : state_subscriptions) {
+    if (changed & s.mask) {
+      s.on_change();
+    }
   }
+}
 
-  state.phone_dialed_num = phone.dialed_number();
+auto calc_frame() -> void {
+  notify_subscriptions(state.dirty());
+
+  state.set_phone_dialed_num(phone.dialed_number());
 
   //
   // fader panel LEDs
   //
 
-  if (state.double_switch[0]) {
-    if (state.fader_mode == FaderMode::RGB) {
+  if (state.double_switch(0)) {
+    if (state.fader_mode() == FaderMode::RGB) {
       leds.fader_analog_string[0] = PicoLed::RGB(128, 0, 0);
       leds.fader_analog_string[1] = PicoLed::RGB(0, 0, 0);
       leds.fader_analog_string[2] = PicoLed::RGB(0, 0, 0);
       buttons8.set_hues(120.f, 0.f);
-    } else if (state.fader_mode == FaderMode::HSV) {
+    } else if (state.fader_mode() == FaderMode::HSV) {
       leds.fader_analog_string[0] = PicoLed::RGB(0, 0, 0);
       leds.fader_analog_string[1] = PicoLed::RGB(0, 128, 0);
       leds.fader_analog_string[2] = PicoLed::RGB(0, 0, 0);
       buttons8.set_hues(60.f, 180.f);
-    } else if (state.fader_mode == FaderMode::Effect) {
+    } else if (state.fader_mode() == FaderMode::Effect) {
       leds.fader_analog_string[0] = PicoLed::RGB(0, 0, 0);
       leds.fader_analog_string[1] = PicoLed::RGB(0, 0, 0);
       leds.fader_analog_string[2] = PicoLed::RGB(0, 0, 128);
@@ -274,21 +349,19 @@ auto calc_frame() -> void {
   // Fan speed
   // Lowest speed should be 10%
   // The PWM is inverted:
-  uint8_t const fan_pwm = std::max(static_cast<uint8_t>(25), state.faders[0]);
+  uint8_t const fan_pwm = std::max(static_cast<uint8_t>(25), state.faders(0));
   pwm_set_gpio_level(FAN_PWM_PIN, fan_pwm);
 
   //
   // 8 arcade buttons RGB lights
   //
-  if (state.arcade_mode == ArcadeMode::Names ||
-      state.arcade_mode == ArcadeMode::Binary) {
-    buttons8.calc_frame(state.tick, state.buttons_8, leds.grb_led_string);
-  } else if (state.arcade_mode == ArcadeMode::SoundGame) {
-    if (!prev_state.has_value() ||
-        state.toggle_upper_left != prev_state->toggle_upper_left) {
-      sound_game.set_enabled(state.toggle_upper_left);
-    }
-    sound_game.calc_frame(state.tick, &leds.grb_led_string[0], state.buttons_8);
+  if (state.arcade_mode() == ArcadeMode::Names ||
+      state.arcade_mode() == ArcadeMode::Binary ||
+      state.arcade_mode() == ArcadeMode::Scope) {
+    buttons8.calc_frame(state.tick, state.buttons_8(), leds.grb_led_string);
+  } else if (state.arcade_mode() == ArcadeMode::SoundGame) {
+    sound_game.calc_frame(state.tick, &leds.grb_led_string[0],
+                          state.buttons_8());
   } else {
     // unimplemented
   }
@@ -298,21 +371,12 @@ auto calc_frame() -> void {
   // (phone arcade button)
   //
 
-  PicoLed::Color arcade1_color;
-  if (state.arcade_1_pressed_since_ms > 0) {
-    auto elapsed =
-        to_ms_since_boot(get_absolute_time()) - state.arcade_1_pressed_since_ms;
-    if (elapsed <= ARCADE_1_COLOR_RETAIN_TIME_MS) {
-      arcade1_color = PicoLed::RGB(0, 0, 128);
-    } else {
-      state.arcade_1_pressed_since_ms = 0;
-    }
-  } else {
-    arcade1_color = PicoLed::RGB(0, 128, 0);
-  }
+  PicoLed::Color const arcade1_color = arcade_1_color_retained
+                                           ? PicoLed::RGB(0, 0, 128)
+                                           : PicoLed::RGB(0, 128, 0);
 
-  if (state.double_toggle[0]) {
-    if (state.dial_in_progress) {
+  if (state.double_toggle(0)) {
+    if (state.dial_in_progress()) {
       leds.grb_led_string[ARCADE_BUTTONS_8_LED_LENGTH] =
           PicoLed::RGB(128, 128, 0); // yellow
     } else {
@@ -324,73 +388,101 @@ auto calc_frame() -> void {
   }
 
   //
-  // analog meter RGB lights
+  // analog meter needle and RGB lights
   //
-  for (int i = FADER_LED_LENGTH; i < fader_and_analog_meter_led_string_length;
-       ++i) {
-    if (state.double_switch[1]) {
-      leds.fader_analog_string[i] = PicoLed::RGBW(0, 0, 0, 64);
-    } else {
-      leds.fader_analog_string[i] = PicoLed::RGB(0, 0, 0);
-    }
-  }
+  analog_gauge.set_source(gauge_source());
+  analog_gauge.calc_frame(gauge_value(analog_gauge.source()),
+                          leds.fader_analog_string + FADER_LED_LENGTH,
+                          ANALOG_METER_LED_LENGTH);
 
-  if (!prev_state.has_value() ||
-      prev_state->double_toggle[0] != state.double_toggle[0]) {
-    phone.switch_on(state.double_toggle[0]);
-  }
   phone.calc_frame(leds.phone_leds);
 
   //
   // fan RGB lights
   //
-  if (!prev_state.has_value() ||
-      prev_state->double_switch[0] != state.double_switch[1]) {
-    fan_leds.set_enabled(state.double_switch[0]);
-  }
   fan_leds.calc_frame(leds.grb_led_string + ARCADE_BUTTONS_8_LED_LENGTH +
                           ARCADE_BUTTONS_1_LED_LENGTH,
-                      FAN_LED_LENGTH, state.faders);
+                      FAN_LED_LENGTH, state.faders_all().data());
 }
 
-int64_t on_frame(alarm_id_t id, void *user_data) {
+uint32_t on_frame(void *user_data) {
   ++state.tick;
   frame_changed = true;
-  return MS_PER_FRAME * 1000; // microseconds
+  return MS_PER_FRAME;
 }
 
+uint32_t on_arcade_1_color_retain_timeout(void *user_data) {
+  arcade_1_color_retained = false;
+  return 0;
+}
+
+TimerWheel::Timer frame_timer(on_frame, nullptr);
+TimerWheel::Timer arcade_1_color_retain_timer(on_arcade_1_color_retain_timeout,
+                                              nullptr);
+
 //---------------------------------------------------------------------------
 
-void play_sound(ArcadeSounds sound) {
-  uint8_t *bytes = reinterpret_cast<uint8_t *>(&sound);
-  uint8_t folder = bytes[1];
-  uint8_t track = bytes[0];
+void play_sound(uint8_t folder, uint8_t track) {
   uint16_t cmd = (folder << 8) | track;
   dfp->sendCmd(dfPlayer::SPECIFY_FOLDER_PLAYBACK, cmd);
 }
 
-void play_sound(uint8_t folder, uint8_t track) {
-  uint16_t cmd = (folder << 8) | track;
-  dfp->sendCmd(dfPlayer::SPECIFY_FOLDER_PLAYBACK, cmd);
+// Sounds are only requested here; sound_arbiter decides once per frame
+// which one is played.
+void request_sound(SoundSource source, uint8_t folder, uint8_t track) {
+  auto const *clip = sound_clips::find(folder, track);
+  sound_arbiter.request(source, folder, track, clip ? clip->duration_ms : 0,
+                        to_ms_since_boot(get_absolute_time()));
+}
+
+void request_sound(SoundSource source, ArcadeSounds sound) {
+  auto const value = static_cast<uint16_t>(sound);
+  request_sound(source, value >> 8, value & 0xff);
+}
+
+void poll_dfplayer() {
+  DfPlayerEvent event;
+  while (dfp->pollEvent(event)) {
+    if (event.type == DfPlayerEvent::Type::Error) {
+      LOG("DFPLAYER error %u", event.param);
+    } else if (event.type == DfPlayerEvent::Type::TrackFinished) {
+      LOG("DFPLAYER finished track %u", event.param);
+    }
+  }
 }
 
-void display_number(Pico7219 *dot_matrix, uint8_t number) {
-  char b[4] = {0, 0, 0, 0};
-  char b2[4] = {' ', ' ', ' ', 0};
-  itoa(number, b, 10);
-  if (number >= 100)
-    std::copy(b, b + 3, b2 + 1);
-  else if (state.buttons_8 >= 10)
-    std::copy(b, b + 2, b2 + 2);
-  else
-    std::copy(b, b + 2, b2 + 3);
-  draw_string(dot_matrix, b2, false);
+void display_number(DotMatrix &dot_matrix, uint8_t number) {
+  dot_matrix.show(bitmaps::numbers[number]);
 }
 
+#ifdef DEBUG_BOUNCE
+void print_bounce_stats(uint8_t device, uint8_t pin, BounceStats const &s) {
+  LOG("BOUNCE io16 dev%u pin %02u: n=%u late=%u last=%u mean=%u dev=%u "
+      "peak=%u window=%u usec",
+      device, pin, s.settled, s.late_bounces, s.last_us, s.mean_us, s.dev_us,
+      s.peak_us, s.window_us);
+}
+
+void print_bounce_stats() {
+  for (uint8_t i = 0; i < 16; ++i) {
+    print_bounce_stats(1, i, io16_dev1.bounce_stats(i));
+    print_bounce_stats(2, i, io16_dev2.bounce_stats(i));
+  }
+  auto const &s = phone_dialing_in_progress.bounce_stats();
+  LOG("BOUNCE dial in progress: n=%u late=%u last=%u mean=%u dev=%u peak=%u "
+      "window=%u usec",
+      s.settled, s.late_bounces, s.last_us, s.mean_us, s.dev_us, s.peak_us,
+      s.window_us);
+}
+#endif
+
 //----------------------------------------------------------------------------
 
 int main() {
   stdio_init_all();
+  serial_out.add(binary_log);
+  timers.init();
+  random_init();
 
   i2c_init(i2c0, I2C_0_BAUD_RATE);
   gpio_set_function(I2C_0_SDA_PIN, GPIO_FUNC_I2C);
@@ -457,11 +549,23 @@ int main() {
   auto phone_leds = PicoLed::addLeds<PicoLed::WS2812B>(
       pio0, 2, PHONE_LEDS_DIN_PIN, PHONE_LEDS_LENGTH, phone_led_format);
 
-  Pico7219 *dot_matrix = pico7219_create(
-      DOT_MATRIX_SPI_CHAN, DOT_MATRIX_SPI_BAUDRATE, DOT_MATRIX_SPI_TX,
-      DOT_MATRIX_SPI_SCK, DOT_MATRIX_SPI_CS, DOT_MATRIX_CHAIN_LEN, false);
-
-  pico7219_switch_off_all(dot_matrix, false);
+  dot_matrix.init();
+  uint8_t const meter_gauge =
+      gauges.add(ANALOG_METER_GAUGE_PIN_1, ANALOG_METER_GAUGE_PIN_2_3,
+                 ANALOG_METER_GAUGE_PIN_4);
+  gauges.init();
+  analog_gauge.init(meter_gauge);
+#ifdef PWM_AUDIO
+  pwm_audio.init();
+#endif
+  scroller.set_speed(DOT_MATRIX_SCROLL_COLUMNS_PER_SEC);
+  for (int i = 0; i < 4; ++i) {
+    scope.configure(SCOPE_CHANNEL_FADER_0 + i, 255, Scope::Style::Bars);
+  }
+  scope.configure(SCOPE_CHANNEL_FRAME_TIME, MS_PER_FRAME * 1000,
+                  Scope::Style::Line);
+  scope.configure(SCOPE_CHANNEL_DIAL_PULSE, SCOPE_DIAL_PULSE_FULL_SCALE_US,
+                  Scope::Style::Bars);
 
   arcade_and_fan_leds.setBrightness(255);
   arcade_and_fan_leds.clear();
@@ -477,24 +581,37 @@ int main() {
   phone_leds.fill(PicoLed::RGBW(0, 0, 0, 16));
   phone_leds.show();
 
-  pico7219_set_intensity(dot_matrix, 0);
-  pico7219_flush(dot_matrix);
+  dot_matrix.set_intensity(0);
 
   uint32_t frame_usec_min = 0;
   uint32_t frame_usec_max = 0;
+  uint32_t frame_usec = 0;
+  uint32_t scope_pulse_edges = 0;
 
-  dfp = new DfPlayerPico<DFPLAYER_UART, DFPLAYER_MINI_TX, DFPLAYER_MINI_RX>();
+  dfp.emplace();
   dfp->reset();
-  sleep_ms(2000);
+  if (!dfp->waitFor(DfPlayerEvent::Type::InitComplete,
+                    DFPLAYER_INIT_TIMEOUT_MS)) {
+    LOG("DFPLAYER did not report ready");
+  }
   dfp->specifyVolume(15);
-  sleep_ms(200);
 
   io16_dev1.init();
   io16_dev2.init();
 
+#ifdef BOUNCE_CAPTURE
+  io16_dev1.set_capture_device(0);
+  io16_dev2.set_capture_device(1);
+  bounce_capture.select_pcf8575(0, 0xffff);
+  bounce_capture.select_pcf8575(1, 0xffff);
+  bounce_capture.select_gpio(PHONE_DIAL_IN_PROGRESS_PIN);
+  bounce_capture.select_gpio(PHONE_DIAL_PULSED_NUMBER);
+  serial_out.add(bounce_capture);
+#endif
+
   bool arcade8_num_changed = false;
 
-  add_alarm_in_ms(MS_PER_FRAME, on_frame, nullptr, false);
+  timers.schedule(frame_timer, MS_PER_FRAME);
 
   int phone_dialing_prev = 0;
 
@@ -505,12 +622,22 @@ int main() {
   bool switch6_changed = false;
   bool toggle_upper_left_changed = false;
 
+  notify_subscriptions(state_mask::all);
+  alloc_tracker.seal();
+
   while (true) {
+    alloc_tracker.set_subsystem(AllocSubsystem::Log);
+    serial_out.drain();
+
+    alloc_tracker.set_subsystem(AllocSubsystem::Sound);
+    poll_dfplayer();
+
+    alloc_tracker.set_subsystem(AllocSubsystem::Input);
     {
-      state.dial_in_progress = !gpio_get(PHONE_DIAL_IN_PROGRESS_PIN);
+      state.set_dial_in_progress(!gpio_get(PHONE_DIAL_IN_PROGRESS_PIN));
       bool const num_switched = gpio_get(PHONE_DIAL_PULSED_NUMBER);
 
-      phone.loop(state.dial_in_progress, num_switched);
+      phone.loop(state.dial_in_progress(), num_switched);
     }
 
     if (io16_dev1.loop()) {
@@ -524,20 +651,27 @@ int main() {
         if (i < 8 && prev == 1 && current == 0) {
           arcade8_num_changed = true;
           // this means the button was pressed down.
-          if (state.arcade_mode == ArcadeMode::Binary) {
-            state.buttons_8 ^= (1 << i);
-          } else if (state.arcade_mode == ArcadeMode::Names) {
-            state.buttons_8 = (1 << i);
-          } else if (state.arcade_mode == ArcadeMode::SoundGame) {
-            state.buttons_8 = (1 << i);
+          if (state.arcade_mode() == ArcadeMode::Binary) {
+            state.set_buttons_8(state.buttons_8() ^ (1 << i));
+#ifdef PWM_AUDIO
+            pwm_audio.play(state.buttons_8() & (1 << i) ? audio_clips::blip
+                                                      : audio_clips::click,
+                           PWM_AUDIO_CLICK_VOLUME);
+#endif
+          } else if (state.arcade_mode() == ArcadeMode::Names) {
+            state.set_buttons_8(1 << i);
+          } else if (state.arcade_mode() == ArcadeMode::SoundGame) {
+            state.set_buttons_8(1 << i);
+          } else if (state.arcade_mode() == ArcadeMode::Scope) {
+            state.set_buttons_8(1 << i);
           }
         }
         if (i == 8 && prev == 1 && current == 0) {
-          state.fader_mode = FaderMode::RGB;
+          state.set_fader_mode(FaderMode::RGB);
         } else if (i == 9 && prev == 1 && current == 0) {
-          state.fader_mode = FaderMode::HSV;
+          state.set_fader_mode(FaderMode::HSV);
         } else if (i == 10 && prev == 1 && current == 0) {
-          state.fader_mode = FaderMode::Effect;
+          state.set_fader_mode(FaderMode::Effect);
         } else if (i >= 11 && i < 16) {
           if (current == 0) {
             // wiring mistakes where made
@@ -555,35 +689,40 @@ int main() {
           }
         }
       }
-      if (state.switch6 != new_switch6) {
-        state.switch6 = new_switch6;
+      if (state.switch6() != new_switch6) {
+        state.set_switch6(new_switch6);
         switch6_changed = true;
       }
-      if (state.switch6 == 0) {
-        state.arcade_mode = ArcadeMode::Binary;
+      if (state.switch6() == 0) {
+        state.set_arcade_mode(ArcadeMode::Binary);
         if (switch6_changed) {
-          state.buttons_8 = 0;
-          state.scroll_dotmatrix = false;
+          state.set_buttons_8(0);
+          state.set_scroll_dotmatrix(false);
         }
-      } else if (state.switch6 == 1) {
-        state.arcade_mode = ArcadeMode::Names;
+      } else if (state.switch6() == 1) {
+        state.set_arcade_mode(ArcadeMode::Names);
         if (switch6_changed) {
-          state.buttons_8 = 1 << 4;
-          state.scroll_dotmatrix = false;
+          state.set_buttons_8(1 << 4);
+          state.set_scroll_dotmatrix(false);
+        }
+      } else if (state.switch6() == 5) {
+        state.set_arcade_mode(ArcadeMode::Scope);
+        if (switch6_changed) {
+          state.set_buttons_8(1 << SCOPE_CHANNEL_FADER_0);
+          state.set_scroll_dotmatrix(false);
         }
       } else {
-        state.arcade_mode = ArcadeMode::SoundGame;
+        state.set_arcade_mode(ArcadeMode::SoundGame);
         if (switch6_changed) {
-          state.buttons_8 = 0;
-          state.scroll_dotmatrix = false;
+          state.set_buttons_8(0);
+          state.set_scroll_dotmatrix(false);
         }
       }
       io16_device1_prev_state = io16_dev1.state();
     }
     if (io16_dev2.loop()) {
       auto const current_state = io16_dev2.state();
-      std::cout << "io16 dev 2 changed to " << std::bitset<16>(current_state)
-                << std::endl;
+      LOG("io16 dev 2 changed to %04x", current_state);
       for (auto i = 0; i < 16; ++i) {
         bool const current = ((1 << i) & current_state) > 0;
         bool const prev = io16_device2_prev_state.has_value()
@@ -591,45 +730,56 @@ int main() {
                               : (!current);
 
         if (i == 0) {
-          state.toggle_upper_left = (current == 1);
+          state.set_toggle_upper_left(current == 1);
           if (current != prev) {
             toggle_upper_left_changed = true;
           }
         } else if (i == 1 && prev == 1 && current == 0) {
-          state.double_toggle[1] = !state.double_toggle[1];
+          state.set_double_toggle(!state.double_toggle(1), 1);
         } else if (i == 2 && prev == 1 && current == 0) {
-          state.double_toggle[0] = !state.double_toggle[0];
+          state.set_double_toggle(!state.double_toggle(0), 0);
         } else if (i == 3) {
-          state.double_switch[0] = (current == 0);
+          state.set_double_switch(current == 0, 0);
         } else if (i == 4) {
-          state.double_switch[1] = (current == 0);
+          state.set_double_switch(current == 0, 1);
         } else if (i == 5 && prev == 1 && current == 0) {
-          state.arcade_1_pressed = true;
-          state.arcade_1_pressed_since_ms =
-              to_ms_since_boot(get_absolute_time());
+          state.set_arcade_1_pressed(true);
+          arcade_1_color_retained = true;
+          timers.schedule(arcade_1_color_retain_timer,
+                          ARCADE_1_COLOR_RETAIN_TIME_MS);
         }
       }
     }
 
     if (frame_changed) {
-#ifdef DEBUG_TIMING
-      auto start = time_us_32();
-#endif
+      auto const start = time_us_32();
 
+      alloc_tracker.set_subsystem(AllocSubsystem::Frame);
       read_adc();
+      state.set_frame_load(
+          std::min<uint32_t>(frame_usec * 255 / (MS_PER_FRAME * 1000), 255));
 
       calc_frame();
       frame_changed = false;
 
-      if (state.scroll_dotmatrix && state.tick % 5 == 0) {
-        pico7219_scroll(dot_matrix, true);
+      alloc_tracker.set_subsystem(AllocSubsystem::Display);
+      if (state.scroll_dotmatrix() && scroller.update(time_us_64())) {
+        scroller.render(dot_matrix);
+        dot_matrix.flush();
       }
 
-      if (prev_state.has_value() &&
-          prev_state->phone_dialed_num != state.phone_dialed_num) {
-        play_sound(1, state.phone_dialed_num);
+      alloc_tracker.set_subsystem(AllocSubsystem::Sound);
+      if (state.changed(state_mask::phone_dialed_num)) {
+#ifdef PWM_AUDIO
+        if (state.phone_dialed_num() >= 0 && state.phone_dialed_num() < 10) {
+          pwm_audio.play(*audio_clips::digits[state.phone_dialed_num()]);
+        }
+#else
+        request_sound(SoundSource::Dial, 1, state.phone_dialed_num());
+#endif
       }
 
+      alloc_tracker.set_subsystem(AllocSubsystem::Leds);
       for (int i = 0; i < grb_led_string_length; ++i) {
         arcade_and_fan_leds.setPixelColor(i, leds.grb_led_string[i]);
       }
@@ -646,91 +796,146 @@ int main() {
       }
       phone_leds.show();
 
+      alloc_tracker.set_subsystem(AllocSubsystem::Display);
       if (arcade8_num_changed || switch6_changed || toggle_upper_left_changed) {
-        std::cout << "update dot matrix" << std::endl;
-        pico7219_switch_off_all(dot_matrix, false);
-        if (state.toggle_upper_left) {
-          if (state.arcade_mode == ArcadeMode::Binary) {
-            display_number(dot_matrix, state.buttons_8);
-          } else if (state.arcade_mode == ArcadeMode::Names) {
-            state.scroll_dotmatrix = false;
-            if (state.buttons_8 == 1) {
-              draw_string(dot_matrix, "MAMA", false);
-              play_sound((state.tick % 3) + 2, 1);
+        LOG("update dot matrix");
+        dot_matrix.clear();
+        if (state.toggle_upper_left()) {
+          if (state.arcade_mode() == ArcadeMode::Binary) {
+            display_number(dot_matrix, state.buttons_8());
+          } else if (state.arcade_mode() == ArcadeMode::Names) {
+            state.set_scroll_dotmatrix(false);
+            if (state.buttons_8() == 1) {
+              dot_matrix.show(bitmaps::mama);
+              request_sound(SoundSource::Names, rng.range(2, 5), 1);
             }
-            if (state.buttons_8 == 2) {
-              draw_string(dot_matrix, "PAPA", false);
-              play_sound((state.tick % 3) + 2, 2);
+            if (state.buttons_8() == 2) {
+              dot_matrix.show(bitmaps::papa);
+              request_sound(SoundSource::Names, rng.range(2, 5), 2);
             }
-            if (state.buttons_8 == 4) {
-              state.scroll_dotmatrix = true;
-              show_text_and_scroll(dot_matrix, "JANNIS    ");
-              play_sound((state.tick % 3) + 2, 3);
+            if (state.buttons_8() == 4) {
+              state.set_scroll_dotmatrix(true);
+              scroller.start("JANNIS    ", time_us_64());
+              scroller.render(dot_matrix);
+              request_sound(SoundSource::Names, rng.range(2, 5), 3);
             }
-            if (state.buttons_8 == 8) {
-              draw_string(dot_matrix, "MARA", false);
-              play_sound((state.tick % 3) + 2, 4);
+            if (state.buttons_8() == 8) {
+              dot_matrix.show(bitmaps::mara);
+              request_sound(SoundSource::Names, rng.range(2, 5), 4);
             }
-            if (state.buttons_8 == 16) {
-              draw_string(dot_matrix, "LUAN", false);
-              play_sound((state.tick % 3) + 2, 5);
+            if (state.buttons_8() == 16) {
+              dot_matrix.show(bitmaps::luan);
+              request_sound(SoundSource::Names, rng.range(2, 5), 5);
             }
-          } else if (state.arcade_mode == ArcadeMode::SoundGame) {
-            state.scroll_dotmatrix = false;
+          } else if (state.arcade_mode() == ArcadeMode::SoundGame) {
+            state.set_scroll_dotmatrix(false);
             // if (sound_game.should_play_sound()) {
             if (true) {
 
               uint8_t button = 0;
               for (int i = 0; i < 8; ++i) {
-                if (((1 << i) & state.buttons_8) > 0) {
+                if (((1 << i) & state.buttons_8()) > 0) {
                   button = i;
                 }
               }
 
-              if (prev_state.has_value() &&
-                  state.buttons_8 != prev_state->buttons_8) {
-                std::cout << "ARCADE BUTTON " << (int)button << std::endl;
+              if (state.changed(state_mask::buttons_8)) {
+                LOG("ARCADE BUTTON %u", button);
                 auto sound = sound_game.sound_for_button(button);
-                play_sound(sound);
-                state.buttons_8 = 0;
+                request_sound(SoundSource::SoundGame, sound);
+                state.set_buttons_8(0);
               }
             }
           }
         }
-        pico7219_flush(dot_matrix);
+        dot_matrix.flush();
       }
       arcade8_num_changed = false;
       switch6_changed = false;
       toggle_upper_left_changed = false;
 
-      if (state.arcade_1_pressed) {
-        std::cout << "ARCADE 1 PRESSED" << std::endl;
-        play_sound(1, 10);
+      if (state.arcade_mode() == ArcadeMode::SoundGame &&
+          state.toggle_upper_left()) {
+        sound_game.draw_frame(dot_matrix);
+        dot_matrix.flush();
       }
 
-      state.arcade_1_pressed = false;
+      for (int i = 0; i < 4; ++i) {
+        scope.push(SCOPE_CHANNEL_FADER_0 + i, state.faders(i));
+      }
+      scope.push(SCOPE_CHANNEL_FRAME_TIME, frame_usec);
+      if (phone.pulse_edges() != scope_pulse_edges) {
+        scope_pulse_edges = phone.pulse_edges();
+        scope.push(SCOPE_CHANNEL_DIAL_PULSE, phone.pulse_interval_us());
+      }
+      if (state.arcade_mode() == ArcadeMode::Scope) {
+        uint8_t channel = 0;
+        while (channel < SCOPE_CHANNELS &&
+               !(state.buttons_8() & (1 << channel))) {
+          channel++;
+        }
+        if (state.toggle_upper_left() && channel < SCOPE_CHANNELS) {
+          scope.render(channel, dot_matrix);
+        } else {
+          dot_matrix.clear();
+        }
+        dot_matrix.flush();
+      }
 
-#ifdef DEBUG_TIMING
-      auto end = time_us_32();
+      if (state.arcade_1_pressed()) {
+        LOG("ARCADE 1 PRESSED");
+        request_sound(SoundSource::Arcade1, 1, 10);
+      }
+
+      state.set_arcade_1_pressed(false);
+
+      alloc_tracker.set_subsystem(AllocSubsystem::Sound);
+      if (auto const sound = sound_arbiter.update(
+              to_ms_since_boot(get_absolute_time()), dfp->playing())) {
+        play_sound(sound->folder, sound->track);
+      }
 
+      frame_usec = time_us_32() - start;
+
+#ifdef DEBUG_TIMING
       // debug frames per second
-      auto dur = end - start;
+      auto dur = frame_usec;
       frame_usec_max = std::max(frame_usec_max, dur);
       frame_usec_min = std::min(frame_usec_min, dur);
       if (state.tick % FPS == 0) {
-        std::cout << "FRAME time min=" << frame_usec_min
-                  << ", max=" << frame_usec_max << " usec" << std::endl;
+        LOG("FRAME time min=%u, max=%u usec", frame_usec_min, frame_usec_max);
       }
       if (state.tick % FPS == 0) {
-        for (int k = 0; k < 4; ++k) {
-          // adc_value_f = ads1115_raw_to_volts(adc_value, &adc);
-          std::cout << "ADC: " << (int)state.faders[k] << " ";
-        }
-        std::cout << std::endl;
+        LOG("ADC: %u %u %u %u", state.faders(0), state.faders(1),
+            state.faders(2), state.faders(3));
+      }
+      if (state.tick % FPS == 0) {
+        auto const dfp_stats = dfp->txStats();
+        LOG("DFPLAYER TX depth=%u max_depth=%u sent=%u coalesced=%u "
+            "dropped=%u",
+            dfp->txDepth(), dfp_stats.max_depth, dfp_stats.sent,
+            dfp_stats.coalesced, dfp_stats.dropped);
+        auto const &sound_stats = sound_arbiter.stats();
+        LOG("SOUNDS played=%u preempted=%u replaced=%u expired=%u "
+            "deduplicated=%u",
+            sound_stats.played, sound_stats.preempted, sound_stats.replaced,
+            sound_stats.expired, sound_stats.deduplicated);
+      }
+      if (state.tick % FPS == 0) {
+        LOG("HEAP allocations=%u frees=%u in use=%u bytes",
+            alloc_tracker.allocations(), alloc_tracker.frees(),
+            alloc_tracker.heap_in_use());
+      }
+#endif
+
+#ifdef DEBUG_BOUNCE
+      if (state.tick % DEBUG_BOUNCE_INTERVAL_FRAMES == 0) {
+        print_bounce_stats();
       }
 #endif
 
-      prev_state = state;
+      state.clear_dirty();
+      alloc_tracker.end_frame();
     }
   }
 
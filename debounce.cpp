@@ -1,8 +1,10 @@
 #include "debounce.h"
+#include "binary_log.h"
+#include "bounce_capture.h"
 #include "hardware/i2c.h"
 
-#include <bitset>
-#include <iostream>
+#include <algorithm>
+#include <iterator>
 
 namespace {
 auto read_pcf8575(i2c_inst_t *i2c, uint8_t addr) -> uint16_t {
@@ -10,28 +12,27 @@ auto read_pcf8575(i2c_inst_t *i2c, uint8_t addr) -> uint16_t {
   uint8_t rxdata[2];
   ret = i2c_read_timeout_us(i2c, addr, rxdata, 2, true, 5 * 1000);
   if (ret != 2) {
-    std::cerr << "read pcf8575 (0x" << std::hex << (int)addr << ") : "
-              << "unexpected return value " << std::dec << ret << std::endl;
+    LOG("read pcf8575 (0x%02x): unexpected return value %d", addr, ret);
   }
   return *reinterpret_cast<uint16_t *>(rxdata);
 }
 } // namespace
 
-int64_t debounce_alarm(alarm_id_t id, void *user_data) {
+uint32_t debounce_alarm(void *user_data) {
   Debounce *d = reinterpret_cast<Debounce *>(user_data);
-  d->alarm_running_ = false;
   d->state_ = gpio_get(d->pin_);
+  d->window_.on_settled();
   return 0;
 }
 
-int64_t debounce_alarm_edge(alarm_id_t id, void *user_data) {
+uint32_t debounce_alarm_edge(void *user_data) {
   DebounceEdge *d = reinterpret_cast<DebounceEdge *>(user_data);
   if (d->state_pending_ == StateChange::Rising)
     d->rising_edge_count_ += 1;
   if (d->state_pending_ == StateChange::Falling)
     d->falling_edge_count_ += 1;
   d->state_pending_ = StateChange::None;
-  d->alarm_running_ = false;
+  d->window_.on_settled();
   return 0;
 }
 
@@ -39,10 +40,15 @@ Debounce_PCF8575::Debounce_PCF8575(i2c_inst_t *i2c, uint8_t addr,
                                    uint32_t debounce_ms)
     : i2c_(i2c), i2c_address_(addr), debounce_ms_(debounce_ms) {
   std::fill(std::begin(debounce_timers_), std::end(debounce_timers_), 0);
+  std::fill(std::begin(last_edge_us_), std::end(last_edge_us_), 0);
+  std::fill(std::begin(settled_us_), std::end(settled_us_), 0);
+  std::fill(std::begin(estimators_), std::end(estimators_),
+            BounceEstimator(debounce_ms * 1000));
 }
 
 auto Debounce_PCF8575::init() -> void {
   debounced_state_ = read_pcf8575(i2c_, i2c_address_);
+  raw_state_ = debounced_state_;
 }
 
 auto Debounce_PCF8575::loop() -> bool {
@@ -57,30 +63,44 @@ auto Debounce_PCF8575::loop() -> bool {
   // Either a previous interrupt indicated that the values of the pins
   // have changed or we have at least one debounce timer that has timed out.
   uint16_t new_state = read_pcf8575(i2c_, i2c_address_);
-  // std::cout << "io16: " << std::bitset<16>(new_state) << std::endl;
+  // LOG("io16: %04x", new_state);
   needs_update_ = false;
+  if (capture_device_ >= 0)
+    bounce_capture.on_pcf8575_read(capture_device_, raw_state_, new_state);
 
   bool state_changed = false;
 
   for (uint8_t i = 0; i < 16; ++i) {
     bool const a = debounced_state_ & (1 << i);
     bool const b = new_state & (1 << i);
+    bool const raw_changed = (raw_state_ ^ new_state) & (1 << i);
 
     if (a != b && is_stopped(i)) {
       // Pin i changed.
+      // If it just settled, the window was too short to cover its bounce.
+      if (settled_us_[i] > 0 &&
+          now - settled_us_[i] < estimators_[i].window_us()) {
+        estimators_[i].on_late_bounce(now - settled_us_[i]);
+      }
       // Start the debounce timer for it.
       start_timer(i, now);
+      last_edge_us_[i] = now;
     } else if (timeout_mask & (1 << i)) {
       // The debounce timer for this pin timed out.
       // Stop the timer, and examine the new_state for this pin.
-      stop_timer(i);
-
       if (a != b) {
         state_changed = true;
         set_debounced(i, b);
+        estimators_[i].on_settled(last_edge_us_[i] - debounce_timers_[i]);
+        settled_us_[i] = now;
       }
+      stop_timer(i);
+    } else if (raw_changed && !is_stopped(i)) {
+      // Bounce within the running debounce window.
+      last_edge_us_[i] = now;
     }
   }
+  raw_state_ = new_state;
 
   if (init_) {
     init_ = false;
@@ -2,14 +2,55 @@
 #include "hardware/i2c.h"
 #include "pico/stdlib.h"
 
-int64_t debounce_alarm(alarm_id_t id, void *user_data);
-int64_t debounce_alarm_edge(alarm_id_t id, void *user_data);
+#include "bounce_estimator.h"
+#include "timer_wheel.h"
+
+uint32_t debounce_alarm(void *user_data);
+uint32_t debounce_alarm_edge(void *user_data);
 
 enum class StateChange { None, Rising, Falling };
 
+// The debounce window of one GPIO input: a timer that closes it and the
+// estimate of how long the input bounces, which sets its length.
+class BounceWindow {
+public:
+  BounceWindow(TimerWheel::Callback on_closed, void *owner,
+               uint32_t debounce_ms)
+      : timer_(on_closed, owner), estimator_(debounce_ms * 1000) {}
+
+  // Opens the window on the first edge, later edges only count as bounce.
+  auto on_edge() -> void {
+    auto const now = time_us_32();
+    if (!timer_.pending()) {
+      if (settled_us_ != 0 && now - settled_us_ < estimator_.window_us())
+        estimator_.on_late_bounce(now - settled_us_);
+      start_us_ = now;
+      timers.schedule(timer_, estimator_.window_ms());
+    }
+    last_edge_us_ = now;
+  }
+
+  // To be called from `on_closed`.
+  auto on_settled() -> void {
+    estimator_.on_settled(last_edge_us_ - start_us_);
+    settled_us_ = time_us_32();
+  }
+
+  auto stats() const -> BounceStats const & { return estimator_.stats(); }
+
+private:
+  TimerWheel::Timer timer_;
+  BounceEstimator estimator_;
+  uint32_t start_us_ = 0;
+  uint32_t last_edge_us_ = 0;
+  uint32_t settled_us_ = 0;
+};
+
 class DebounceEdge {
 public:
-  DebounceEdge(uint32_t debounce_ms) : debounce_ms_(debounce_ms) {}
+  DebounceEdge(uint32_t debounce_ms)
+      : debounce_ms_(debounce_ms),
+        window_(debounce_alarm_edge, this, debounce_ms) {}
   void on_event(uint32_t events) {
     if (debounce_ms_ == 0) {
       if (events & GPIO_IRQ_EDGE_FALL)
@@ -23,10 +64,7 @@ public:
         state_pending_ = StateChange::Rising;
       else
         state_pending_ = StateChange::None;
-      if (!alarm_running_) {
-        add_alarm_in_ms(debounce_ms_, debounce_alarm_edge, this, true);
-        alarm_running_ = true;
-      }
+      window_.on_edge();
     }
   }
 
@@ -35,8 +73,11 @@ public:
     falling_edge_count_ = 0;
   }
 
-  bool alarm_running_ = false;
+  auto bounce_stats() const -> BounceStats const & { return window_.stats(); }
+
+  // A zero disables debouncing: every edge is counted.
   uint32_t debounce_ms_ = 4;
+  BounceWindow window_;
   volatile int rising_edge_count_ = 0;
   volatile int falling_edge_count_ = 0;
   volatile mutable StateChange state_pending_ = StateChange::None;
@@ -45,19 +86,16 @@ public:
 class Debounce {
 public:
   Debounce(uint8_t pin, uint32_t debounce_ms)
-      : pin_(pin), debounce_ms_(debounce_ms) {}
-  void on_event(uint32_t events) {
-    if (!alarm_running_) {
-      add_alarm_in_ms(debounce_ms_, debounce_alarm, this, false);
-      alarm_running_ = true;
-    }
-  }
+      : pin_(pin), debounce_ms_(debounce_ms),
+        window_(debounce_alarm, this, debounce_ms) {}
+  void on_event(uint32_t events) { window_.on_edge(); }
 
   bool state() const { return state_; }
+  auto bounce_stats() const -> BounceStats const & { return window_.stats(); }
 
-  bool alarm_running_ = false;
   uint pin_;
   uint32_t debounce_ms_ = 4;
+  BounceWindow window_;
   volatile bool state_ = true;
 };
 
@@ -67,14 +105,20 @@ public:
 
   auto init() -> void;
 
+  // Streams the raw pin changes of this device to bounce_capture.
+  auto set_capture_device(uint8_t device) -> void { capture_device_ = device; }
+
   void on_pcf8575_interrupt() { needs_update_ = true; }
 
   auto loop() -> bool;
   auto state() const -> uint16_t { return debounced_state_; };
+  auto bounce_stats(uint8_t pin) const -> BounceStats const & {
+    return estimators_[pin].stats();
+  }
 
 private:
   inline auto timed_out(uint8_t i, uint64_t now) const -> bool {
-    return now > 0 && now - debounce_timers_[i] > debounce_ms_ * 1000;
+    return now > 0 && now - debounce_timers_[i] > estimators_[i].window_us();
   }
   inline auto is_stopped(uint8_t i) const -> bool {
     return debounce_timers_[i] == 0;
@@ -105,9 +149,16 @@ private:
   volatile bool needs_update_ = true;
   uint32_t const debounce_ms_ = 4;
   uint16_t debounced_state_ = 0;
+  uint16_t raw_state_ = 0;
 
   // A zero means: No timer running.
   // A positive value gives the start time of the timer in usec since boot.
   uint64_t debounce_timers_[16];
+  // Time of the last raw edge seen while the timer was running.
+  uint64_t last_edge_us_[16];
+  // Time the pin last settled into a new debounced state, or zero.
+  uint64_t settled_us_[16];
+  BounceEstimator estimators_[16];
   bool init_ = true;
+  int8_t capture_device_ = -1;
 };
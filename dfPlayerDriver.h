@@ -1,33 +1,193 @@
 #pragma once
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
 #include "pico/stdlib.h"
 
 #include "dfPlayer/dfPlayer.h"
 
+#include "dfplayer_protocol.h"
+#include "dfplayer_queue.h"
+
+#define DFPLAYER_EVENT_QUEUE 8
+
+// sendCmd() only queues the frame; the UART TX interrupt sends it, so the
+// caller never waits for the 9600 baud line (~10 ms per frame). Only one
+// frame at a time is handed to the UART's FIFO, the others wait in the
+// queue, where a later request can still replace them.
+//
+// Frames from the module are parsed in the UART RX interrupt and queued as
+// events for pollEvent(). ready() and playing() follow the events, so
+// they are only up to date while the events are being polled.
 template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
 class DfPlayerPico : public DfPlayer<DfPlayerPico<UART, TX_PIN, RX_PIN>> {
 public:
   DfPlayerPico();
   inline void uartSend(uint8_t *a_cmd);
 
+  uint8_t txDepth() const { return tx_queue_.depth(); }
+  DfPlayerQueue::Stats txStats() const;
+
+  bool pollEvent(DfPlayerEvent &event);
+  // Polls events until one of `type` arrives; other events are dropped.
+  bool waitFor(DfPlayerEvent::Type type, uint32_t timeout_ms);
+
+  bool ready() const { return ready_; }
+  bool playing() const { return playing_; }
+  uint32_t rxDropped() const { return rx_dropped_; }
+  DfPlayerParser const &parser() const { return parser_; }
+
 private:
+  static uart_inst_t *uart() { return UART == 0 ? uart0 : uart1; }
+  static bool txFifoLow();
+  static void onUartIrq();
+  void fillTxFifo();
+  void drainRxFifo();
+
+  static inline DfPlayerPico *instance_ = nullptr;
+  DfPlayerQueue tx_queue_;
+
+  DfPlayerParser parser_;
+  DfPlayerEvent events_[DFPLAYER_EVENT_QUEUE];
+  volatile uint8_t events_head_ = 0;
+  volatile uint8_t events_tail_ = 0;
+  volatile uint32_t rx_dropped_ = 0;
+
+  bool ready_ = false;
+  bool playing_ = false;
 };
 
 template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
 DfPlayerPico<UART, TX_PIN, RX_PIN>::DfPlayerPico() {
-  if constexpr (UART == 0)
-    uart_init(uart0, 9600);
-  else
-    uart_init(uart1, 9600);
+  uart_init(uart(), 9600);
+  // The TX interrupt fires once the FIFO is down to 1/8 (4 bytes), which
+  // is the tail of the previous frame.
+  hw_write_masked(&uart_get_hw(uart())->ifls,
+                  0 << UART_UARTIFLS_TXIFLSEL_LSB,
+                  UART_UARTIFLS_TXIFLSEL_BITS);
 
   // Set the GPIO pin mux to the UART - 8 is TX, 9 is RX
   gpio_set_function(TX_PIN, GPIO_FUNC_UART);
   gpio_set_function(RX_PIN, GPIO_FUNC_UART);
+
+  instance_ = this;
+  irq_set_exclusive_handler(UART == 0 ? UART0_IRQ : UART1_IRQ, onUartIrq);
+  irq_set_enabled(UART == 0 ? UART0_IRQ : UART1_IRQ, true);
+  uart_set_irq_enables(uart(), true, false);
 }
 
 template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
 inline void DfPlayerPico<UART, TX_PIN, RX_PIN>::uartSend(uint8_t *a_cmd) {
-  if constexpr (UART == 0)
-    uart_write_blocking(uart0, a_cmd, SERIAL_CMD_SIZE);
-  else
-    uart_write_blocking(uart1, a_cmd, SERIAL_CMD_SIZE);
+  auto const irq = save_and_disable_interrupts();
+  tx_queue_.push(a_cmd);
+  fillTxFifo();
+  restore_interrupts(irq);
+
+  switch (a_cmd[DFPLAYER_FRAME_CMD]) {
+  case 0x0C: // reset
+    ready_ = false;
+    playing_ = false;
+    break;
+  case 0x0E: // pause
+  case 0x16: // stop
+    playing_ = false;
+    break;
+  case 0x03:
+  case 0x08:
+  case 0x0D: // resume
+  case 0x0F:
+  case 0x12:
+  case 0x14:
+    playing_ = true;
+    break;
+  }
+}
+
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+bool DfPlayerPico<UART, TX_PIN, RX_PIN>::pollEvent(DfPlayerEvent &event) {
+  if (events_tail_ == events_head_)
+    return false;
+  event = events_[events_tail_ % DFPLAYER_EVENT_QUEUE];
+  events_tail_ = events_tail_ + 1;
+
+  using Type = DfPlayerEvent::Type;
+  if (event.type == Type::InitComplete) {
+    ready_ = true;
+  } else if (event.type == Type::TrackFinished ||
+             event.type == Type::Error) {
+    playing_ = false;
+  } else if (event.type == Type::Status) {
+    playing_ = (event.param & 0xff) == 1;
+  }
+  return true;
+}
+
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+bool DfPlayerPico<UART, TX_PIN, RX_PIN>::waitFor(DfPlayerEvent::Type type,
+                                                 uint32_t timeout_ms) {
+  auto const deadline = make_timeout_time_ms(timeout_ms);
+  DfPlayerEvent event;
+  while (!time_reached(deadline)) {
+    while (pollEvent(event)) {
+      if (event.type == type)
+        return true;
+    }
+    tight_loop_contents();
+  }
+  return false;
+}
+
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+DfPlayerQueue::Stats DfPlayerPico<UART, TX_PIN, RX_PIN>::txStats() const {
+  auto const irq = save_and_disable_interrupts();
+  auto const stats = tx_queue_.stats();
+  restore_interrupts(irq);
+  return stats;
+}
+
+// Whether the previous frame has (nearly) left the TX FIFO: it is empty,
+// or down to the interrupt level. The raw interrupt status is only set
+// when the FIFO drains through that level, not when it starts out empty.
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+bool DfPlayerPico<UART, TX_PIN, RX_PIN>::txFifoLow() {
+  auto const *hw = uart_get_hw(uart());
+  return (hw->fr & UART_UARTFR_TXFE_BITS) ||
+         (hw->ris & UART_UARTRIS_TXRIS_BITS);
+}
+
+// Called with interrupts disabled.
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+void DfPlayerPico<UART, TX_PIN, RX_PIN>::fillTxFifo() {
+  if (txFifoLow()) {
+    uint8_t byte;
+    for (int i = 0; i < DFPLAYER_FRAME_SIZE && tx_queue_.pop(byte); ++i) {
+      uart_putc_raw(uart(), byte);
+    }
+  }
+  // Writing the frame took the FIFO above the interrupt level, so the TX
+  // interrupt stays quiet until the frame has (nearly) gone out.
+  uart_set_irq_enables(uart(), true, !tx_queue_.empty());
+}
+
+// Called from the UART interrupt.
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+void DfPlayerPico<UART, TX_PIN, RX_PIN>::drainRxFifo() {
+  DfPlayerEvent event;
+  while (uart_is_readable(uart())) {
+    if (!parser_.feed(uart_getc(uart()), event))
+      continue;
+    if (static_cast<uint8_t>(events_head_ - events_tail_) >=
+        DFPLAYER_EVENT_QUEUE) {
+      rx_dropped_ = rx_dropped_ + 1;
+    } else {
+      events_[events_head_ % DFPLAYER_EVENT_QUEUE] = event;
+      events_head_ = events_head_ + 1;
+    }
+  }
+}
+
+template <uint8_t UART, uint8_t TX_PIN, uint8_t RX_PIN>
+void DfPlayerPico<UART, TX_PIN, RX_PIN>::onUartIrq() {
+  instance_->drainRxFifo();
+  instance_->fillTxFifo();
 }
@@ -0,0 +1,103 @@
+#include "dfplayer_protocol.h"
+
+#define DFPLAYER_START 0x7E
+#define DFPLAYER_VERSION 0xFF
+#define DFPLAYER_LENGTH 0x06
+#define DFPLAYER_END 0xEF
+
+namespace {
+auto event_type(uint8_t cmd) -> DfPlayerEvent::Type {
+  using Type = DfPlayerEvent::Type;
+  switch (cmd) {
+  case 0x3A:
+    return Type::StorageInserted;
+  case 0x3B:
+    return Type::StorageRemoved;
+  case 0x3C: // USB
+  case 0x3D: // SD card
+  case 0x3E: // flash
+    return Type::TrackFinished;
+  case 0x3F:
+    return Type::InitComplete;
+  case 0x40:
+    return Type::Error;
+  case 0x41:
+    return Type::Ack;
+  case 0x42:
+    return Type::Status;
+  case 0x43:
+    return Type::Volume;
+  case 0x47: // USB
+  case 0x48: // SD card
+  case 0x49: // flash
+    return Type::TrackCount;
+  case 0x4B: // USB
+  case 0x4C: // SD card
+  case 0x4D: // flash
+    return Type::CurrentTrack;
+  case 0x4E:
+    return Type::FolderTrackCount;
+  case 0x4F:
+    return Type::FolderCount;
+  default:
+    return Type::Other;
+  }
+}
+} // namespace
+
+// Two's complement of the sum of version, length, command, feedback and
+// parameter.
+auto dfplayer_checksum(const uint8_t *frame) -> uint16_t {
+  uint16_t sum = 0;
+  for (int i = 1; i < 7; ++i) {
+    sum += frame[i];
+  }
+  return -sum;
+}
+
+auto dfplayer_make_frame(uint8_t *frame, uint8_t cmd, uint16_t param,
+                         bool feedback) -> void {
+  frame[0] = DFPLAYER_START;
+  frame[1] = DFPLAYER_VERSION;
+  frame[2] = DFPLAYER_LENGTH;
+  frame[3] = cmd;
+  frame[4] = feedback ? 1 : 0;
+  frame[5] = param >> 8;
+  frame[6] = param & 0xff;
+  uint16_t const checksum = dfplayer_checksum(frame);
+  frame[7] = checksum >> 8;
+  frame[8] = checksum & 0xff;
+  frame[9] = DFPLAYER_END;
+}
+
+auto DfPlayerParser::feed(uint8_t byte, DfPlayerEvent &event) -> bool {
+  if (length_ == 0 && byte != DFPLAYER_START)
+    return false;
+  frame_[length_++] = byte;
+
+  bool const bad_header = (length_ == 2 && byte != DFPLAYER_VERSION) ||
+                          (length_ == 3 && byte != DFPLAYER_LENGTH);
+  if (bad_header) {
+    framing_errors_++;
+    // The byte may start the next frame.
+    length_ = 0;
+    return byte == DFPLAYER_START ? feed(byte, event) : false;
+  }
+  if (length_ < DFPLAYER_FRAME_SIZE)
+    return false;
+
+  length_ = 0;
+  if (byte != DFPLAYER_END) {
+    framing_errors_++;
+    return false;
+  }
+  if (((frame_[7] << 8) | frame_[8]) != dfplayer_checksum(frame_)) {
+    checksum_errors_++;
+    return false;
+  }
+
+  event.cmd = frame_[3];
+  event.type = event_type(event.cmd);
+  event.param = (frame_[5] << 8) | frame_[6];
+  return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dfplayer_queue.h"
+
+// Frames sent by the DFPlayer, see dfplayer_queue.h for the layout.
+struct DfPlayerEvent {
+  enum class Type : uint8_t {
+    StorageInserted,
+    StorageRemoved,
+    TrackFinished,
+    InitComplete,
+    Error,
+    Ack,
+    Status,
+    Volume,
+    TrackCount,
+    CurrentTrack,
+    FolderTrackCount,
+    FolderCount,
+    Other,
+  };
+
+  // Parameter of an Error event.
+  enum ErrorCode : uint16_t {
+    ErrorBusy = 1,
+    ErrorSleeping = 2,
+    ErrorSerialData = 3,
+    ErrorChecksum = 4,
+    ErrorTrackOutOfRange = 5,
+    ErrorTrackNotFound = 6,
+    ErrorInsertion = 7,
+    ErrorSdRead = 8,
+    ErrorEnteredSleep = 10,
+  };
+
+  Type type;
+  uint8_t cmd;
+  // TrackFinished: track number, InitComplete: bitmask of the available
+  // storage devices, Status: device << 8 | (0 stopped, 1 playing,
+  // 2 paused), queries: the value.
+  uint16_t param;
+};
+
+auto dfplayer_checksum(const uint8_t *frame) -> uint16_t;
+// Writes a complete frame (DFPLAYER_FRAME_SIZE bytes) to `frame`.
+auto dfplayer_make_frame(uint8_t *frame, uint8_t cmd, uint16_t param,
+                         bool feedback = false) -> void;
+
+// Reassembles response frames from the UART byte stream. Bytes that do not
+// belong to a valid frame are skipped.
+class DfPlayerParser {
+public:
+  DfPlayerParser() = default;
+
+  // Returns true if `byte` completed a valid frame.
+  auto feed(uint8_t byte, DfPlayerEvent &event) -> bool;
+
+  auto checksum_errors() const -> uint32_t { return checksum_errors_; }
+  auto framing_errors() const -> uint32_t { return framing_errors_; }
+
+private:
+  uint8_t frame_[DFPLAYER_FRAME_SIZE];
+  uint8_t length_ = 0;
+  uint32_t checksum_errors_ = 0;
+  uint32_t framing_errors_ = 0;
+};
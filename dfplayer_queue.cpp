@@ -0,0 +1,71 @@
+#include "dfplayer_queue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Commands that overwrite each other's effect. 0 means "never coalesce".
+auto coalesce_group(uint8_t cmd) -> uint8_t {
+  switch (cmd) {
+  case 0x03: // play track
+  case 0x08: // loop track
+  case 0x0F: // play track in folder
+  case 0x12: // play track in mp3 folder
+  case 0x14: // play track in large folder
+    return 1;
+  case 0x06: // set volume
+    return 2;
+  case 0x07: // set equalizer
+    return 3;
+  default:
+    return 0;
+  }
+}
+} // namespace
+
+auto DfPlayerQueue::push(const uint8_t *frame) -> bool {
+  uint8_t const group = coalesce_group(frame[DFPLAYER_FRAME_CMD]);
+  if (group) {
+    // The head frame may already be on the wire.
+    for (uint8_t i = offset_ ? 1 : 0; i < count_; ++i) {
+      if (coalesce_group(at(i)[DFPLAYER_FRAME_CMD]) != group)
+        continue;
+      stats_.coalesced++;
+      // Taking its place would move the frame ahead of the commands queued
+      // after it (e.g. play, pause, play), so drop it and append instead.
+      bool reorders = false;
+      for (uint8_t j = i + 1; j < count_; ++j)
+        reorders |= coalesce_group(at(j)[DFPLAYER_FRAME_CMD]) == 0;
+      if (!reorders) {
+        std::memcpy(at(i), frame, DFPLAYER_FRAME_SIZE);
+        return true;
+      }
+      for (uint8_t j = i + 1; j < count_; ++j)
+        std::memcpy(at(j - 1), at(j), DFPLAYER_FRAME_SIZE);
+      count_--;
+      break;
+    }
+  }
+
+  if (count_ == DFPLAYER_QUEUE_FRAMES) {
+    stats_.dropped++;
+    return false;
+  }
+  std::memcpy(at(count_), frame, DFPLAYER_FRAME_SIZE);
+  count_++;
+  stats_.max_depth = std::max(stats_.max_depth, count_);
+  return true;
+}
+
+auto DfPlayerQueue::pop(uint8_t &byte) -> bool {
+  if (count_ == 0)
+    return false;
+  byte = frames_[head_][offset_++];
+  if (offset_ == DFPLAYER_FRAME_SIZE) {
+    offset_ = 0;
+    head_ = (head_ + 1) % DFPLAYER_QUEUE_FRAMES;
+    count_--;
+    stats_.sent++;
+  }
+  return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// DFPlayer serial frames are 10 bytes:
+//   0x7E 0xFF 0x06 cmd feedback param_hi param_lo checksum_hi checksum_lo 0xEF
+#define DFPLAYER_FRAME_SIZE 10
+#define DFPLAYER_FRAME_CMD 3
+#define DFPLAYER_QUEUE_FRAMES 8
+
+// The transmit queue of the DFPlayer driver.
+//
+// The driver pushes whole frames; the UART interrupt pops them byte by
+// byte. A frame that replaces the state set by a waiting frame (e.g. two
+// play commands, or two volume changes) takes that frame's place instead
+// of being appended, so only the latest one is sent. If other commands
+// (stop, pause, ...) wait behind that frame, it is dropped and the new one
+// appended, so the order of the commands is kept. Frames that have started
+// to go out are never touched.
+//
+// Not thread safe: the caller serializes access (the driver disables
+// interrupts around push()).
+class DfPlayerQueue {
+public:
+  struct Stats {
+    uint32_t sent = 0;
+    uint32_t coalesced = 0;
+    uint32_t dropped = 0;
+    uint8_t max_depth = 0;
+  };
+
+  DfPlayerQueue() = default;
+
+  // Returns false if the queue was full and the frame has been dropped.
+  auto push(const uint8_t *frame) -> bool;
+  auto pop(uint8_t &byte) -> bool;
+
+  auto empty() const -> bool { return count_ == 0; }
+  // Frames waiting or being sent.
+  auto depth() const -> uint8_t { return count_; }
+  auto stats() const -> Stats const & { return stats_; }
+
+private:
+  auto at(uint8_t i) -> uint8_t * {
+    return frames_[(head_ + i) % DFPLAYER_QUEUE_FRAMES];
+  }
+
+  uint8_t frames_[DFPLAYER_QUEUE_FRAMES][DFPLAYER_FRAME_SIZE];
+  uint8_t head_ = 0;
+  uint8_t count_ = 0;
+  // Bytes of the head frame that have been popped.
+  uint8_t offset_ = 0;
+  Stats stats_;
+};
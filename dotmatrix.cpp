@@ -1,70 +1,234 @@
 #include "dotmatrix.h"
 
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#include <algorithm>
 #include <cstring>
 
-extern uint8_t console_font_8x8[];
-
-// Draw a character to the library. Note that the width of the "virtual
-// display" can be much longer than the physical module chain, and
-// off-display elements can later be scrolled into view. However, it's
-// the job of the application, not the library, to size the virtual
-// display sufficiently to fit all the text in.
-//
-// chr is an offset in the font table, which starts with character 32 (space).
-// It isn't an ASCII character.
-void draw_character(Pico7219 *pico7219, uint8_t chr, int x_offset, BOOL flush) {
-  for (int i = 0; i < 8; i++) // row
-  {
-    // The font elements are one byte wide even though, as its an 8x5 font,
-    //   only the top five bits of each byte are used.
-    uint8_t v = console_font_8x8[8 * chr + i];
-    for (int j = 0; j < 8; j++) // column
-    {
-      int sel = 1 << j;
-      if (sel & v)
-        pico7219_switch_on(pico7219, 7 - i, 7 - j + x_offset, FALSE);
-    }
+#include "font.h"
+
+// MAX7219 registers
+#define MAX7219_REG_DIGIT_0 0x01
+#define MAX7219_REG_DECODE_MODE 0x09
+#define MAX7219_REG_INTENSITY 0x0A
+#define MAX7219_REG_SCAN_LIMIT 0x0B
+#define MAX7219_REG_SHUTDOWN 0x0C
+#define MAX7219_REG_DISPLAY_TEST 0x0F
+
+namespace {
+DotMatrix *dma_dot_matrix = nullptr;
+int dma_dot_matrix_channel = -1;
+
+void dot_matrix_dma_irq() {
+  if (dma_dot_matrix_channel >= 0 &&
+      dma_channel_get_irq0_status(dma_dot_matrix_channel)) {
+    dma_channel_acknowledge_irq0(dma_dot_matrix_channel);
+    dma_dot_matrix->on_dma_complete();
   }
-  if (flush)
-    pico7219_flush(pico7219);
 }
+} // namespace
+
+DotMatrix::DotMatrix(spi_inst_t *spi, uint baudrate, uint8_t tx_pin,
+                     uint8_t sck_pin, uint8_t cs_pin)
+    : spi_(spi), baudrate_(baudrate), tx_pin_(tx_pin), sck_pin_(sck_pin),
+      cs_pin_(cs_pin) {}
+
+auto DotMatrix::init() -> void {
+  spi_init(spi_, baudrate_);
+  spi_set_format(spi_, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+  gpio_set_function(tx_pin_, GPIO_FUNC_SPI);
+  gpio_set_function(sck_pin_, GPIO_FUNC_SPI);
 
-// Draw a string of text on the (virtual) display. This function assumes
-// that the library has already been configured to provide a virtual
-// chain of LED modules that is long enough to fit all the text onto.
-void draw_string(Pico7219 *pico7219, const char *s, bool flush) {
-  int x = 0;
+  // The chip select has to stay low for the whole chain, so it is driven
+  // by hand instead of by the SPI peripheral.
+  gpio_init(cs_pin_);
+  gpio_set_dir(cs_pin_, GPIO_OUT);
+  gpio_put(cs_pin_, 1);
+
+  dma_channel_ = dma_claim_unused_channel(true);
+  dma_channel_config config = dma_channel_get_default_config(dma_channel_);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_dreq(&config, spi_get_dreq(spi_, true));
+  channel_config_set_read_increment(&config, true);
+  channel_config_set_write_increment(&config, false);
+  dma_channel_configure(dma_channel_, &config, &spi_get_hw(spi_)->dr, tx_[0],
+                        sizeof(tx_[0]), false);
+
+  dma_dot_matrix = this;
+  dma_dot_matrix_channel = dma_channel_;
+  dma_channel_set_irq0_enabled(dma_channel_, true);
+  irq_add_shared_handler(DMA_IRQ_0, dot_matrix_dma_irq,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+
+  write_register(MAX7219_REG_DISPLAY_TEST, 0);
+  write_register(MAX7219_REG_DECODE_MODE, 0);
+  write_register(MAX7219_REG_SCAN_LIMIT, DOT_MATRIX_ROWS - 1);
+  write_register(MAX7219_REG_SHUTDOWN, 1);
+  clear();
+  flush();
+}
+
+// Writes the same value to a register of every module in the chain.
+auto DotMatrix::write_register(uint8_t reg, uint8_t value) -> void {
+  wait_idle();
+  uint8_t buf[2 * DOT_MATRIX_CHAIN_LEN];
+  for (int m = 0; m < DOT_MATRIX_CHAIN_LEN; ++m) {
+    buf[2 * m] = reg;
+    buf[2 * m + 1] = value;
+  }
+  gpio_put(cs_pin_, 0);
+  spi_write_blocking(spi_, buf, sizeof(buf));
+  gpio_put(cs_pin_, 1);
+}
+
+auto DotMatrix::set_intensity(uint8_t intensity) -> void {
+  write_register(MAX7219_REG_INTENSITY, intensity & 0x0f);
+}
+
+auto DotMatrix::clear() -> void {
+  std::memset(rows_, 0, sizeof(rows_));
+}
+
+// Draws a glyph with its left edge at column `x`. Each glyph row is one
+// byte, so this is 8 byte writes if x is a multiple of 8 and 16 otherwise.
+auto DotMatrix::draw_character(char c, int x) -> void {
+  if (x <= -8 || x >= DOT_MATRIX_COLUMNS)
+    return;
+
+  auto const &glyph = font::glyph_rows(c);
+  int const module = x >> 3; // rounds towards -inf
+  int const shift = x & 7;
+  for (int r = 0; r < DOT_MATRIX_ROWS; ++r) {
+    if (module >= 0)
+      rows_[r][module] |= glyph[r] << shift;
+    if (shift && module + 1 < DOT_MATRIX_CHAIN_LEN)
+      rows_[r][module + 1] |= glyph[r] >> (8 - shift);
+  }
+}
+
+auto DotMatrix::draw_string(const char *s, int x) -> void {
   while (*s) {
-    draw_character(pico7219, *s, x, FALSE);
+    draw_character(*s, x);
     s++;
     x += 8;
   }
-  if (flush)
-    pico7219_flush(pico7219);
 }
 
-// Get the number of horizontal pixels that a string will take. Since each
-// font element is five pixels wide, and there is one pixel between each
-// character, we just multiply the string length by 6.
-int get_string_length_pixels(const char *s) { return std::strlen(s) * 8; }
+auto DotMatrix::blit_columns(const uint8_t *columns) -> void {
+  // Transpose each module's 8x8 block from columns to rows.
+  for (int m = 0; m < DOT_MATRIX_CHAIN_LEN; ++m) {
+    const uint8_t *c = columns + 8 * m;
+    for (int r = 0; r < DOT_MATRIX_ROWS; ++r) {
+      uint8_t row = 0;
+      for (int k = 0; k < 8; ++k) {
+        row |= ((c[k] >> r) & 1) << k;
+      }
+      rows_[r][m] = row;
+    }
+  }
+}
+
+auto DotMatrix::blit(Sprite const &sprite, int x, int y, BlitOp op) -> void {
+  static_assert(DOT_MATRIX_COLUMNS <= 32, "a framebuffer row must fit a word");
+  if (sprite.width == 0 || x >= DOT_MATRIX_COLUMNS || x + sprite.width <= 0)
+    return;
+
+  uint32_t const sprite_mask =
+      sprite.width >= 32 ? ~0u : (1u << sprite.width) - 1;
+  uint32_t const visible_mask =
+      DOT_MATRIX_COLUMNS >= 32 ? ~0u : (1u << DOT_MATRIX_COLUMNS) - 1;
+  // From here on -32 < x < 32.
+  uint32_t const mask =
+      (x >= 0 ? sprite_mask << x : sprite_mask >> -x) & visible_mask;
+
+  for (int i = 0; i < sprite.height; ++i) {
+    int const screen_row = y + i;
+    if (screen_row < 0 || screen_row >= DOT_MATRIX_ROWS)
+      continue;
+    uint32_t bits = sprite.rows[i];
+    bits = (x >= 0 ? bits << x : bits >> -x) & mask;
+
+    // The modules are mounted upside down, see font.h. Bit k of byte m is
+    // column 8 * m + k, i.e. the bytes of a row form a little endian word.
+    uint8_t *row = rows_[DOT_MATRIX_ROWS - 1 - screen_row];
+    uint32_t word = 0;
+    std::memcpy(&word, row, DOT_MATRIX_CHAIN_LEN);
+    switch (op) {
+    case BlitOp::Copy:
+      word = (word & ~mask) | bits;
+      break;
+    case BlitOp::Or:
+      word |= bits;
+      break;
+    case BlitOp::And:
+      word &= bits | ~mask;
+      break;
+    case BlitOp::Xor:
+      word ^= bits;
+      break;
+    }
+    std::memcpy(row, &word, DOT_MATRIX_CHAIN_LEN);
+  }
+}
+
+auto DotMatrix::show(DotMatrixFrame const &frame) -> void {
+  static_assert(sizeof(frame) == sizeof(rows_));
+  std::memcpy(rows_, frame.data(), sizeof(rows_));
+}
+
+auto DotMatrix::flush() -> void {
+  wait_idle();
+
+  tx_count_ = 0;
+  for (int r = 0; r < DOT_MATRIX_ROWS; ++r) {
+    if (sent_valid_ &&
+        std::memcmp(sent_[r], rows_[r], DOT_MATRIX_CHAIN_LEN) == 0)
+      continue;
+    std::memcpy(sent_[r], rows_[r], DOT_MATRIX_CHAIN_LEN);
 
-// Get the number of 8x8 LED modules that would be needed to accomodate the
-// string of text. That's the number of pixels divided by 8 (the module
-// width), and then one added to round up.
-int get_string_length_modules(const char *s) {
-  return get_string_length_pixels(s) / 8 + 1;
+    // The first bytes shifted out end up in the last module of the chain.
+    uint8_t *buf = tx_[tx_count_++];
+    for (int i = 0; i < DOT_MATRIX_CHAIN_LEN; ++i) {
+      buf[2 * i] = MAX7219_REG_DIGIT_0 + r;
+      buf[2 * i + 1] = rows_[r][DOT_MATRIX_CHAIN_LEN - 1 - i];
+    }
+  }
+  sent_valid_ = true;
+
+  if (tx_count_ > 0) {
+    tx_next_ = 0;
+    busy_ = true;
+    start_row();
+  }
+}
+
+auto DotMatrix::wait_idle() const -> void {
+  while (busy_) {
+    tight_loop_contents();
+  }
+}
+
+auto DotMatrix::start_row() -> void {
+  gpio_put(cs_pin_, 0);
+  dma_channel_transfer_from_buffer_now(dma_channel_, tx_[tx_next_],
+                                       sizeof(tx_[0]));
 }
 
-// Show a string of characters, and then scroll it across the display.
-// This function uses pico7219_set_virtual_chain_length() to ensure that
-// there are enough "virtual" modules in the display chain to fit
-// the whole string. It then scrolls it enough times to scroll the
-// whole string right off the end.
-void show_text_and_scroll(Pico7219 *pico7219, const char *string) {
-  pico7219_set_virtual_chain_length(pico7219,
-                                    get_string_length_modules(string));
-  draw_string(pico7219, string, false);
-  pico7219_flush(pico7219);
-
-  int l = get_string_length_pixels(string);
+auto DotMatrix::on_dma_complete() -> void {
+  // The DMA is done once the last byte is in the FIFO; the MAX7219 latches
+  // the row on the rising chip select, so wait until it has been shifted
+  // out (at most a few usec).
+  while (spi_is_busy(spi_)) {
+    tight_loop_contents();
+  }
+  gpio_put(cs_pin_, 1);
+
+  tx_next_ = tx_next_ + 1;
+  if (tx_next_ < tx_count_) {
+    start_row();
+  } else {
+    busy_ = false;
+  }
 }
@@ -1,6 +1,92 @@
 #pragma once
 
-#include <pico7219/pico7219.h>
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
 
-void draw_string(Pico7219 *pico7219, const char *s, bool flush);
-void show_text_and_scroll(Pico7219 *pico7219, const char *string);
+#include <array>
+#include <cstdint>
+
+// Number of chained MAX7219 8x8 modules.
+#define DOT_MATRIX_CHAIN_LEN 4
+#define DOT_MATRIX_ROWS 8
+#define DOT_MATRIX_COLUMNS (8 * DOT_MATRIX_CHAIN_LEN)
+
+// A complete framebuffer image, laid out like DotMatrix's framebuffer.
+using DotMatrixFrame =
+    std::array<std::array<uint8_t, DOT_MATRIX_CHAIN_LEN>, DOT_MATRIX_ROWS>;
+
+// How DotMatrix::blit() combines a sprite with the framebuffer.
+enum class BlitOp { Copy, Or, And, Xor };
+
+// A 1-bit image of at most 32 columns. rows[0] is the top row; bit x of a
+// row is column x, counted from the left.
+struct Sprite {
+  uint8_t width;
+  uint8_t height;
+  const uint32_t *rows;
+};
+
+// A chain of MAX7219 driven 8x8 LED modules.
+//
+// The framebuffer is stored the way the MAX7219 expects it: one byte per
+// module and row (a "digit" register), bit k is column 8 * module + k.
+// Module 0 is the first module in the chain. Glyphs are blitted as whole
+// bytes from a font table that is prepared at compile time (see font.h).
+//
+// flush() only sends the rows that differ from what the modules already
+// show. The transfer runs via DMA: the DMA interrupt toggles the chip
+// select between rows and starts the next one, so flush() returns
+// immediately.
+class DotMatrix {
+public:
+  DotMatrix(spi_inst_t *spi, uint baudrate, uint8_t tx_pin, uint8_t sck_pin,
+            uint8_t cs_pin);
+
+  auto init() -> void;
+  auto set_intensity(uint8_t intensity) -> void;
+
+  auto clear() -> void;
+  auto draw_character(char c, int x) -> void;
+  auto draw_string(const char *s, int x = 0) -> void;
+  // Replaces the whole framebuffer with DOT_MATRIX_COLUMNS column bytes
+  // (bit r is row r).
+  auto blit_columns(const uint8_t *columns) -> void;
+  // Draws a sprite with its top left corner at column `x` and row `y`
+  // (0 is the top row), clipped to the display. Each row is combined with
+  // the framebuffer as one 32 bit word.
+  auto blit(Sprite const &sprite, int x, int y, BlitOp op = BlitOp::Or)
+      -> void;
+  // Replaces the whole framebuffer with a pre-rendered image (see
+  // dotmatrix_bitmaps.h).
+  auto show(DotMatrixFrame const &frame) -> void;
+
+  // Sends the changed rows of the visible part of the framebuffer.
+  auto flush() -> void;
+  // Blocks until the previous flush has been sent.
+  auto wait_idle() const -> void;
+
+  // Called from the DMA interrupt.
+  auto on_dma_complete() -> void;
+
+private:
+  auto write_register(uint8_t reg, uint8_t value) -> void;
+  auto start_row() -> void;
+
+  spi_inst_t *spi_;
+  uint baudrate_;
+  uint8_t tx_pin_;
+  uint8_t sck_pin_;
+  uint8_t cs_pin_;
+
+  uint8_t rows_[DOT_MATRIX_ROWS][DOT_MATRIX_CHAIN_LEN] = {};
+
+  // What the modules currently show (or will, once the DMA is done).
+  uint8_t sent_[DOT_MATRIX_ROWS][DOT_MATRIX_CHAIN_LEN] = {};
+  bool sent_valid_ = false;
+
+  int dma_channel_ = -1;
+  uint8_t tx_[DOT_MATRIX_ROWS][2 * DOT_MATRIX_CHAIN_LEN];
+  uint8_t tx_count_ = 0;
+  volatile uint8_t tx_next_ = 0;
+  volatile bool busy_ = false;
+};
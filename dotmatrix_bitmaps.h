@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "dotmatrix.h"
+#include "font.h"
+
+// Dot matrix images of fixed texts, rendered at compile time from the font
+// and stored in flash. Showing one is a single DotMatrix::show().
+
+namespace bitmaps {
+
+// Same as DotMatrix::draw_string() at x = 0 on an empty framebuffer.
+constexpr auto render(const char *s) -> DotMatrixFrame {
+  DotMatrixFrame frame{};
+  for (int m = 0; m < DOT_MATRIX_CHAIN_LEN && s[m]; ++m) {
+    auto const &glyph = font::glyph_rows(s[m]);
+    for (int r = 0; r < DOT_MATRIX_ROWS; ++r) {
+      frame[r][m] = glyph[r];
+    }
+  }
+  return frame;
+}
+
+// The number right aligned, e.g. "  42".
+constexpr auto render_number(uint8_t number) -> DotMatrixFrame {
+  char s[DOT_MATRIX_CHAIN_LEN + 1] = {};
+  for (int i = 0; i < DOT_MATRIX_CHAIN_LEN; ++i) {
+    s[i] = ' ';
+  }
+  int i = DOT_MATRIX_CHAIN_LEN - 1;
+  do {
+    s[i--] = '0' + number % 10;
+    number /= 10;
+  } while (number > 0);
+  return render(s);
+}
+
+constexpr auto make_numbers() -> std::array<DotMatrixFrame, 256> {
+  std::array<DotMatrixFrame, 256> numbers{};
+  for (int n = 0; n < 256; ++n) {
+    numbers[n] = render_number(n);
+  }
+  return numbers;
+}
+
+inline constexpr auto numbers = make_numbers();
+
+inline constexpr auto mama = render("MAMA");
+inline constexpr auto papa = render("PAPA");
+inline constexpr auto mara = render("MARA");
+inline constexpr auto luan = render("LUAN");
+
+} // namespace bitmaps
@@ -40,10 +40,12 @@ def collect_sounds():
             name = name.replace("-", "_")
             name = name.replace(".mp3", "")
             name = name.replace(".wav", "")
-            new_fname = f"{i:03d}"
             i += 1
-            
-            sounds.append((f, i, cat, name, f"{dest}/{new_fname}.wav"))
+
+            # The DFPlayer only looks at the number, the rest of the name
+            # is the category and name for generate-sound-manifest.py.
+            new_fname = f"{i:03d}_{cat}__{name}.mp3"
+            sounds.append((f, i, cat, name, f"{dest}/{new_fname}"))
 
     return sounds
 
@@ -60,9 +62,14 @@ for i, (f, sound_num, cat, name, new_fname) in enumerate(sds):
     enum_f.write("\n")
 enum_f.write("};\n")
 
+os.makedirs(dest, exist_ok=True)
+for f, sound_num, cat, name, new_fname in sds:
+    shutil.copyfile(f, new_fname)
+
+print("Now run ./generate-sound-manifest.py")
+
 for i, (f, sound_num, cat, name, new_fname) in enumerate(sds):
     if False:
-        #shutil.copyfile(f, new_fname)
         cmd = f"ffmpeg -i '{f}' -acodec pcm_s16le -ac 1 -ar 44100 '{new_fname}'"
         print(cmd)
         os.system(cmd)
@@ -2,8 +2,6 @@
 
 #include <pico/stdlib.h>
 
-#include <iostream>
-
 #include "color.h"
 
 #define FPS 60
@@ -21,7 +19,7 @@ void FanLEDs::set_mode(FaderMode mode) {
 }
 
 void FanLEDs::calc_frame(PicoLed::Color *strip_begin, uint8_t led_count,
-                         uint8_t *faders) {
+                         uint8_t const *faders) {
   for (int i = 0; i < led_count; ++i) {
     if (enabled_) {
       if (mode_ == FaderMode::RGB) {
@@ -11,7 +11,7 @@ public:
   void set_mode(FaderMode);
 
   void calc_frame(PicoLed::Color *strip_begin, uint8_t led_count,
-                  uint8_t *faders);
+                  uint8_t const *faders);
 
 private:
   void next_frame();
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "font_8x8_data.h"
+
+// The 8x8 console font, transformed at compile time into the layout of the
+// dot matrix framebuffer (see dotmatrix.h).
+//
+// The modules are mounted upside down: font row i ends up on framebuffer
+// row 7 - i, and font bit j (bit 7 is the leftmost pixel) on column 7 - j.
+
+namespace font {
+
+constexpr auto glyph_count = sizeof(font_data::console_font_8x8) / 8;
+static_assert(glyph_count >= 128, "font must cover ASCII");
+
+using Glyph = std::array<uint8_t, 8>;
+
+constexpr auto reverse_bits(uint8_t v) -> uint8_t {
+  uint8_t r = 0;
+  for (int i = 0; i < 8; ++i) {
+    if (v & (1 << i))
+      r |= 1 << (7 - i);
+  }
+  return r;
+}
+
+// rows[c][r]: framebuffer row r of glyph c, bit k is column k.
+constexpr auto make_rows() -> std::array<Glyph, glyph_count> {
+  std::array<Glyph, glyph_count> rows{};
+  for (size_t c = 0; c < glyph_count; ++c) {
+    for (int r = 0; r < 8; ++r) {
+      rows[c][r] = reverse_bits(font_data::console_font_8x8[8 * c + 7 - r]);
+    }
+  }
+  return rows;
+}
+
+inline constexpr auto rows = make_rows();
+
+// columns[c][k]: column k of glyph c, bit r is framebuffer row r.
+constexpr auto make_columns() -> std::array<Glyph, glyph_count> {
+  std::array<Glyph, glyph_count> columns{};
+  for (size_t c = 0; c < glyph_count; ++c) {
+    for (int k = 0; k < 8; ++k) {
+      for (int r = 0; r < 8; ++r) {
+        if (rows[c][r] & (1 << k))
+          columns[c][k] |= 1 << r;
+      }
+    }
+  }
+  return columns;
+}
+
+inline constexpr auto columns = make_columns();
+
+inline constexpr auto glyph_rows(char c) -> Glyph const & {
+  return rows[static_cast<uint8_t>(c) % glyph_count];
+}
+
+inline constexpr auto glyph_columns(char c) -> Glyph const & {
+  return columns[static_cast<uint8_t>(c) % glyph_count];
+}
+
+} // namespace font
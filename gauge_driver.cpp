@@ -0,0 +1,196 @@
+#include "gauge_driver.h"
+
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#include <cmath>
+
+#include "vid2805.h"
+
+namespace {
+GaugeDriver *gauge_driver = nullptr;
+
+void gauge_driver_alarm(uint alarm_num) { gauge_driver->on_alarm(); }
+} // namespace
+
+auto GaugeDriver::add(uint8_t pin_1, uint8_t pin_2_3, uint8_t pin_4)
+    -> uint8_t {
+  hard_assert(count_ < GAUGE_MAX_MOTORS);
+  uint8_t const motor = count_++;
+  pins_[motor][0] = pin_1;
+  pins_[motor][1] = pin_2_3;
+  pins_[motor][2] = pin_4;
+  profile_[motor] = motion::Profile::SCurve;
+  return motor;
+}
+
+auto GaugeDriver::init() -> void {
+  for (uint8_t m = 0; m < count_; ++m) {
+    for (auto pin : pins_[m]) {
+      uint const slice = pwm_gpio_to_slice_num(pin);
+      uint32_t const channel = pwm_gpio_to_channel(pin) == PWM_CHAN_B
+                                   ? PWM_CH0_CC_B_BITS
+                                   : PWM_CH0_CC_A_BITS;
+      // E.g. GP3 and GP19 are both channel B of slice 1.
+      hard_assert(!(cc_mask_[slice] & channel));
+      cc_mask_[slice] |= channel;
+      gpio_set_function(pin, GPIO_FUNC_PWM);
+      pwm_config config = pwm_get_default_config();
+      pwm_config_set_wrap(&config, VID28_PWM_WRAP);
+      pwm_init(slice, &config, true);
+    }
+    set_levels(m);
+  }
+  for (uint s = 0; s < NUM_PWM_SLICES; ++s) {
+    if (cc_mask_[s])
+      hw_write_masked(&pwm_hw->slice[s].cc, cc_[s], cc_mask_[s]);
+  }
+
+  gauge_driver = this;
+  alarm_num_ = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback(alarm_num_, gauge_driver_alarm);
+}
+
+auto GaugeDriver::reset(uint8_t motor, int direction, float hz) -> void {
+  int32_t const to_go = (direction > 0) ? 360 * 12 : -360 * 12;
+  move(motor, position_[motor] + to_go, hz, true);
+}
+
+auto GaugeDriver::set_zero(uint8_t motor, float degrees) -> void {
+  zero_[motor] = std::round(degrees * 12);
+}
+
+auto GaugeDriver::step_to(uint8_t motor, float degrees, float hz) -> void {
+  move(motor, std::round(degrees * 12) + zero_[motor], hz, false);
+}
+
+auto GaugeDriver::set_profile(uint8_t motor, motion::Profile profile)
+    -> void {
+  auto const irq = save_and_disable_interrupts();
+  profile_[motor] = profile;
+  restore_interrupts(irq);
+}
+
+auto GaugeDriver::angle(uint8_t motor) const -> float {
+  return (position_[motor] - zero_[motor]) / 12.0f;
+}
+
+auto GaugeDriver::moving(uint8_t motor) const -> bool {
+  auto const irq = save_and_disable_interrupts();
+  bool const result =
+      direction_[motor] != 0 || position_[motor] != target_[motor];
+  restore_interrupts(irq);
+  return result;
+}
+
+auto GaugeDriver::move(uint8_t motor, int32_t target, float hz,
+                       bool zero_when_done) -> void {
+  uint16_t const max_level =
+      motion::max_level(profile_[motor], std::lround(hz * 360 * 12));
+  auto const irq = save_and_disable_interrupts();
+  target_[motor] = target;
+  max_level_[motor] = max_level;
+  zero_when_done_[motor] = zero_when_done;
+  if (!running_) {
+    running_ = true;
+    next_tick_us_ = time_us_64() + GAUGE_TICK_US;
+    if (hardware_alarm_set_target(alarm_num_,
+                                  from_us_since_boot(next_tick_us_)))
+      on_alarm();
+  }
+  restore_interrupts(irq);
+}
+
+auto GaugeDriver::on_alarm() -> void {
+  do {
+    // Catch up if interrupts were blocked for longer than a tick.
+    while (next_tick_us_ <= time_us_64()) {
+      if (!tick()) {
+        running_ = false;
+        return;
+      }
+      next_tick_us_ += GAUGE_TICK_US;
+    }
+  } while (hardware_alarm_set_target(alarm_num_,
+                                     from_us_since_boot(next_tick_us_)));
+}
+
+// Returns false once all motors are idle.
+auto GaugeDriver::tick() -> bool {
+  bool active = false;
+  uint8_t dirty = 0;
+  for (uint8_t m = 0; m < count_; ++m) {
+    if (direction_[m] == 0 && position_[m] == target_[m] &&
+        substeps_left_[m] == 0)
+      continue;
+    active = true;
+    due_us_[m] -= GAUGE_TICK_US;
+
+    // The substeps of a microstep are spread evenly over its interval.
+    if (substeps_left_[m] > 0) {
+      int32_t const left =
+          due_us_[m] <= 0 ? 0
+                          : (due_us_[m] * detail::substeps_ +
+                             interval_us_[m] - 1) /
+                                interval_us_[m];
+      if (left < substeps_left_[m]) {
+        int32_t const phase =
+            phase_[m] + step_[m] * (substeps_left_[m] - left);
+        phase_[m] = (phase + VID28_TABLE_SIZE) % VID28_TABLE_SIZE;
+        substeps_left_[m] = left;
+        set_levels(m);
+        for (auto pin : pins_[m]) {
+          dirty |= 1 << pwm_gpio_to_slice_num(pin);
+        }
+      }
+    }
+    if (due_us_[m] > 0)
+      continue;
+
+    motion::State state{direction_[m], level_[m]};
+    int8_t const step =
+        motion::advance(target_[m] - position_[m], state, max_level_[m]);
+    direction_[m] = state.direction;
+    level_[m] = state.level;
+    if (step == 0) {
+      due_us_[m] = 0;
+      if (zero_when_done_[m]) {
+        position_[m] = 0;
+        target_[m] = 0;
+      }
+      continue;
+    }
+    position_[m] += step;
+    step_[m] = step;
+    substeps_left_[m] = detail::substeps_;
+    interval_us_[m] = motion::interval_us(profile_[m], level_[m]);
+    due_us_[m] += interval_us_[m];
+  }
+
+  for (uint s = 0; dirty; ++s, dirty >>= 1) {
+    if (!(dirty & 1))
+      continue;
+    if (cc_mask_[s] == (PWM_CH0_CC_A_BITS | PWM_CH0_CC_B_BITS)) {
+      pwm_hw->slice[s].cc = cc_[s];
+    } else {
+      // The other channel is not ours (e.g. the fan).
+      hw_write_masked(&pwm_hw->slice[s].cc, cc_[s], cc_mask_[s]);
+    }
+  }
+  return active;
+}
+
+// Updates cc_ for the motor's current phase.
+auto GaugeDriver::set_levels(uint8_t motor) -> void {
+  for (uint8_t k = 0; k < 3; ++k) {
+    uint8_t const pin = pins_[motor][k];
+    uint32_t const level = vid28::pin_levels[k][phase_[motor]];
+    uint const slice = pwm_gpio_to_slice_num(pin);
+    if (pwm_gpio_to_channel(pin) == PWM_CHAN_B) {
+      cc_[slice] = (cc_[slice] & ~PWM_CH0_CC_B_BITS) |
+                   (level << PWM_CH0_CC_B_LSB);
+    } else {
+      cc_[slice] = (cc_[slice] & ~PWM_CH0_CC_A_BITS) | level;
+    }
+  }
+}
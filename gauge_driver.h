@@ -0,0 +1,85 @@
+#pragma once
+
+#include "hardware/pwm.h"
+#include "pico/stdlib.h"
+
+#include <cstdint>
+
+#include "motion_profile.h"
+
+#define GAUGE_MAX_MOTORS 4
+// All motors are advanced from one alarm at this period, however many
+// there are. The shortest microstep interval (motion_profile.h) is 556
+// usec, so a microstep is late by at most a fifth of it.
+#define GAUGE_TICK_US 100
+
+// Drives up to GAUGE_MAX_MOTORS VID28-05 gauge steppers (see vid2805.h)
+// from a single hardware alarm.
+//
+// The motion state is kept as a struct of arrays, so that the interrupt
+// walks a few small contiguous arrays. Each tick, every moving motor whose
+// microstep is due is advanced by the planner of motion_profile.h, and the
+// substeps of the running microsteps are played out. The new PWM levels
+// are collected per slice and written with one store per slice, both
+// channels at once. The alarm stops while all motors are idle.
+class GaugeDriver {
+public:
+  GaugeDriver() = default;
+
+  // Registers a motor before init(); returns its index.
+  auto add(uint8_t pin_1, uint8_t pin_2_3, uint8_t pin_4) -> uint8_t;
+  // Sets up the PWM of all motors and claims the alarm.
+  auto init() -> void;
+
+  // Turns a full revolution against the end stop; afterwards the motor is
+  // at angle 0.
+  auto reset(uint8_t motor, int direction, float hz) -> void;
+  auto set_zero(uint8_t motor, float degrees) -> void;
+  // Can be called at any time, a moving needle follows the new target.
+  // `hz` is the top speed in revolutions per second.
+  auto step_to(uint8_t motor, float degrees, float hz) -> void;
+  auto set_profile(uint8_t motor, motion::Profile profile) -> void;
+
+  auto angle(uint8_t motor) const -> float;
+  auto moving(uint8_t motor) const -> bool;
+  auto count() const -> uint8_t { return count_; }
+
+  // Called from the alarm interrupt.
+  auto on_alarm() -> void;
+
+private:
+  auto move(uint8_t motor, int32_t target, float hz, bool zero_when_done)
+      -> void;
+  auto tick() -> bool;
+  auto set_levels(uint8_t motor) -> void;
+
+  uint8_t count_ = 0;
+  int alarm_num_ = -1;
+  uint64_t next_tick_us_ = 0;
+  volatile bool running_ = false;
+
+  // Per motor, in 1/12 degrees.
+  volatile int32_t position_[GAUGE_MAX_MOTORS] = {};
+  volatile int32_t target_[GAUGE_MAX_MOTORS] = {};
+  int32_t zero_[GAUGE_MAX_MOTORS] = {};
+  // Time until the next microstep, and the length of the current one.
+  int32_t due_us_[GAUGE_MAX_MOTORS] = {};
+  uint16_t interval_us_[GAUGE_MAX_MOTORS] = {};
+  uint16_t level_[GAUGE_MAX_MOTORS] = {};
+  volatile uint16_t max_level_[GAUGE_MAX_MOTORS] = {};
+  int8_t direction_[GAUGE_MAX_MOTORS] = {};
+  // Index into vid28::pin_levels, and the substeps of the current
+  // microstep that are still to do in the direction of step_.
+  uint8_t phase_[GAUGE_MAX_MOTORS] = {};
+  uint8_t substeps_left_[GAUGE_MAX_MOTORS] = {};
+  int8_t step_[GAUGE_MAX_MOTORS] = {};
+  motion::Profile profile_[GAUGE_MAX_MOTORS] = {};
+  volatile bool zero_when_done_[GAUGE_MAX_MOTORS] = {};
+  // GPIO of pin 1, 2/3 and 4.
+  uint8_t pins_[GAUGE_MAX_MOTORS][3] = {};
+
+  // The compare registers as they will be written; a slice is only
+  // written as a whole if both channels belong to gauges.
+  uint32_t cc_[NUM_PWM_SLICES] = {};
+  uint32_t cc_mask_[NUM_PWM_SLICES] = {};
+};
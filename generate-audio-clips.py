@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+
+# Encodes the short clips played by the on-chip PWM audio output (see
+# pwm_audio.h) to IMA-ADPCM and writes them as a C++ header. Runs as part
+# of the build:
+#
+#   ./generate-audio-clips.py --output build/audio_clips.h
+#
+# The phone digits come from sounds/01, the UI blips are synthesized. The
+# header also holds a CRC-32 of every decoded clip, so that the firmware
+# decoder can be checked bit-exact against the encoder on the host
+# (host/audio_bench.cpp).
+
+import argparse
+import math
+import os
+import random
+import struct
+import wave
+import zlib
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+
+# Keep in sync with pwm_audio.h
+SAMPLE_RATE = 22050
+
+# Leading and trailing samples below this level are cut, so that a clip
+# starts right away.
+SILENCE_LEVEL = 300
+
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37,
+    41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173,
+    190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+    7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818,
+    18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]  # fmt: skip
+
+
+class Decoder:
+    """Same arithmetic as AdpcmDecoder in adpcm.cpp."""
+
+    def __init__(self):
+        self.predictor = 0
+        self.index = 0
+
+    def decode(self, nibble):
+        step = STEP_TABLE[self.index]
+        diff = step >> 3
+        if nibble & 1:
+            diff += step >> 2
+        if nibble & 2:
+            diff += step >> 1
+        if nibble & 4:
+            diff += step
+        self.predictor += -diff if nibble & 8 else diff
+        self.predictor = max(-32768, min(32767, self.predictor))
+        self.index = max(0, min(88, self.index + INDEX_TABLE[nibble]))
+        return self.predictor
+
+
+def encode(samples):
+    """Returns (adpcm bytes, decoded samples)."""
+    decoder = Decoder()
+    nibbles = []
+    decoded = []
+    for s in samples:
+        step = STEP_TABLE[decoder.index]
+        delta = s - decoder.predictor
+        nibble = 0
+        if delta < 0:
+            nibble = 8
+            delta = -delta
+        if delta >= step:
+            nibble |= 4
+            delta -= step
+        if delta >= step >> 1:
+            nibble |= 2
+            delta -= step >> 1
+        if delta >= step >> 2:
+            nibble |= 1
+        nibbles.append(nibble)
+        decoded.append(decoder.decode(nibble))
+    if len(nibbles) & 1:
+        nibbles.append(0)
+    data = bytes(lo | (hi << 4) for lo, hi in zip(nibbles[::2], nibbles[1::2]))
+    return data, decoded
+
+
+def read_wav(path):
+    with wave.open(path) as w:
+        if w.getsampwidth() != 2:
+            raise SystemExit(f"{path}: only 16 bit PCM is supported")
+        channels = w.getnchannels()
+        rate = w.getframerate()
+        raw = w.readframes(w.getnframes())
+    samples = struct.unpack(f"<{len(raw) // 2}h", raw)
+    if channels > 1:
+        samples = [
+            sum(samples[i : i + channels]) // channels
+            for i in range(0, len(samples), channels)
+        ]
+    return resample(list(samples), rate, SAMPLE_RATE)
+
+
+def resample(samples, rate, new_rate):
+    if rate == new_rate:
+        return samples
+    ratio = rate / new_rate
+    if ratio > 1:
+        # Box filter against aliasing before dropping samples.
+        width = math.ceil(ratio)
+        acc = 0
+        filtered = []
+        for i, s in enumerate(samples):
+            acc += s
+            if i >= width:
+                acc -= samples[i - width]
+            filtered.append(acc // min(i + 1, width))
+        samples = filtered
+    out = []
+    for i in range(int(len(samples) / ratio)):
+        x = i * ratio
+        j = int(x)
+        a = samples[j]
+        b = samples[min(j + 1, len(samples) - 1)]
+        out.append(round(a + (b - a) * (x - j)))
+    return out
+
+
+def trim(samples):
+    loud = [i for i, s in enumerate(samples) if abs(s) > SILENCE_LEVEL]
+    if not loud:
+        return samples
+    return samples[loud[0] : loud[-1] + 1]
+
+
+def tone(freq, ms, amplitude=12000, decay_ms=None):
+    n = SAMPLE_RATE * ms // 1000
+    decay = (decay_ms or ms) * SAMPLE_RATE / 1000 / 3
+    return [
+        round(amplitude * math.exp(-i / decay) * math.sin(2 * math.pi * freq * i / SAMPLE_RATE))
+        for i in range(n)
+    ]
+
+
+def click(ms=6, amplitude=10000):
+    rnd = random.Random(1)
+    n = SAMPLE_RATE * ms // 1000
+    return [round(amplitude * (1 - i / n) * (rnd.random() * 2 - 1)) for i in range(n)]
+
+
+def clips():
+    digits_dir = os.path.join(ROOT, "sounds", "01")
+    for d in range(10):
+        path = os.path.join(digits_dir, f"{d:03d}_de_{d}.wav")
+        yield f"digit_{d}", trim(read_wav(path)), os.path.relpath(path, ROOT)
+    yield "blip", tone(1760, 60), "synthesized"
+    yield "blop", tone(880, 90), "synthesized"
+    yield "click", click(), "synthesized"
+
+
+def render():
+    out = []
+    w = out.append
+    w("#pragma once")
+    w("")
+    w("// Generated by generate-audio-clips.py, do not edit.")
+    w("")
+    w('#include "adpcm.h"')
+    w("")
+    w("namespace audio_clips {")
+    names = []
+    for name, samples, source in clips():
+        data, decoded = encode(samples)
+        crc = zlib.crc32(struct.pack(f"<{len(decoded)}h", *decoded))
+        names.append((name, crc))
+        w("")
+        w(f"// {source}: {len(samples)} samples, {len(data)} bytes")
+        w(f"inline constexpr uint8_t {name}_data[] = {{")
+        for i in range(0, len(data), 16):
+            w("    " + " ".join(f"0x{b:02x}," for b in data[i : i + 16]))
+        w("};")
+        w(f"inline constexpr AdpcmClip {name} = {{{name}_data, {len(samples)}}};")
+    w("")
+    w("inline constexpr AdpcmClip const *digits[10] = {")
+    w("    " + ", ".join(f"&digit_{d}" for d in range(10)) + ",")
+    w("};")
+    w("")
+    w("// CRC-32 of the decoded samples (little endian int16).")
+    w("struct Check {")
+    w("  const char *name;")
+    w("  AdpcmClip const *clip;")
+    w("  uint32_t decoded_crc32;")
+    w("};")
+    w("inline constexpr Check checks[] = {")
+    for name, crc in names:
+        w(f'    {{"{name}", &{name}, 0x{crc:08x}}},')
+    w("};")
+    w("")
+    w("} // namespace audio_clips")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+    text = render()
+    with open(args.output, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
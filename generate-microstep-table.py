@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+# Writes the PWM levels that drive the VID28-05 gauge steppers (see
+# vid2805.h) as a C++ header. Runs as part of the build:
+#
+#   ./generate-microstep-table.py --entries 96 --output build/vid28_microsteps.h
+#
+# The levels follow the coil current model of the datasheet in
+# parts/vid28-05/vid28_model.py, sampled at `entries` points per electrical
+# cycle (24 microsteps), i.e. entries / 24 substeps per microstep.
+# host/microstep_check.cpp checks the result against the datasheet.
+
+import argparse
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(ROOT, "parts", "vid28-05"))
+
+import vid28_model  # noqa: E402
+
+PINS = ["pin 1", "pin 2/3", "pin 4"]
+
+
+def levels(entries, wrap):
+    """PWM levels [pin][entry] in 0..wrap."""
+    samples = [
+        vid28_model.pin_voltages(i * vid28_model.WAVELENGTH / entries)
+        for i in range(entries)
+    ]
+    peak = max(abs(v) for s in samples for v in s)
+    return [
+        [round(wrap * (1 + s[p] / peak) / 2) for s in samples]
+        for p in range(len(PINS))
+    ]
+
+
+def render(entries, wrap, table):
+    out = []
+    w = out.append
+    w("#pragma once")
+    w("")
+    w(
+        "// Generated by generate-microstep-table.py "
+        f"--entries {entries} --wrap {wrap}, do not edit."
+    )
+    w("")
+    w("#include <cstdint>")
+    w("")
+    w(f"#define VID28_TABLE_SIZE {entries}")
+    w(f"#define VID28_PWM_WRAP {wrap}")
+    w("")
+    w("namespace vid28 {")
+    w("")
+    w("// PWM level of pin 1, 2/3 and 4 over one electrical cycle.")
+    w(f"inline constexpr uint16_t pin_levels[3][{entries}] = {{")
+    for pin, row in zip(PINS, table):
+        w(f"    // {pin}")
+        w("    {")
+        for i in range(0, entries, 12):
+            w("        " + " ".join(f"{v}," for v in row[i : i + 12]))
+        w("    },")
+    w("};")
+    w("")
+    w("} // namespace vid28")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--entries", type=int, default=96, choices=[24, 96, 192])
+    parser.add_argument("--wrap", type=int, default=1023)
+    parser.add_argument("--output", required=True)
+    args = parser.parse_args()
+    text = render(args.entries, args.wrap, levels(args.entries, args.wrap))
+    with open(args.output, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
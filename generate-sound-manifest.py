@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+
+# Generates sound_manifest.h from the files under sounds/: folder, track,
+# category, duration and size of every clip the DFPlayer can play.
+#
+#   ./generate-sound-manifest.py           # rewrite sound_manifest.h
+#   ./generate-sound-manifest.py --check   # fail if it is out of date
+#
+# Files are named NNN_<name>.{mp3,wav} (the DFPlayer only uses the number).
+# The category is the part of the name before "__" (see
+# download-retro-sounds.py) or else the default category of the folder.
+
+import argparse
+import glob
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+SOUNDS_DIR = os.path.join(ROOT, "sounds")
+MANIFEST = os.path.join(ROOT, "sound_manifest.h")
+
+# The order defines SoundCategory, keep the existing entries stable.
+CATEGORIES = [
+    "phone",
+    "names",
+    "alarms_rings_and_sirens",
+    "blips_and_beeps",
+    "movement_jump_and_drop",
+    "noise_and_engine",
+    "score_sounds",
+    "shots_and_explosions",
+    "sweeps",
+    "transformation",
+]
+
+FOLDER_CATEGORIES = {
+    1: "phone",
+    2: "names",
+    3: "names",
+    4: "names",
+}
+
+FILE_NAME = re.compile(r"^(\d{3})_?(.*)\.(mp3|wav)$", re.IGNORECASE)
+
+
+class ManifestError(Exception):
+    pass
+
+
+def wav_duration(data):
+    if data[:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ManifestError("not a RIFF/WAVE file")
+    pos = 12
+    byte_rate = None
+    while pos + 8 <= len(data):
+        chunk_id, size = struct.unpack_from("<4sI", data, pos)
+        body = pos + 8
+        if chunk_id == b"fmt ":
+            (byte_rate,) = struct.unpack_from("<I", data, body + 8)
+        elif chunk_id == b"data":
+            if not byte_rate:
+                raise ManifestError("data chunk before fmt chunk")
+            size = min(size, len(data) - body)
+            return size / byte_rate
+        pos = body + size + (size & 1)
+    raise ManifestError("no data chunk")
+
+
+# Bit rates in kbit/s by [version is MPEG 1][layer][index]
+MP3_BITRATES = {
+    (True, 1): [0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448],
+    (True, 2): [0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384],
+    (True, 3): [0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320],
+    (False, 1): [0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256],
+    (False, 2): [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160],
+    (False, 3): [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160],
+}
+MP3_SAMPLE_RATES = {
+    3: [44100, 48000, 32000],  # MPEG 1
+    2: [22050, 24000, 16000],  # MPEG 2
+    0: [11025, 12000, 8000],  # MPEG 2.5
+}
+
+
+def mp3_frame(data, pos):
+    """Returns (length, samples, sample_rate) of the frame at pos or None."""
+    if pos + 4 > len(data):
+        return None
+    (h,) = struct.unpack_from(">I", data, pos)
+    if (h >> 21) & 0x7FF != 0x7FF:
+        return None
+    version = (h >> 19) & 3
+    layer = 4 - ((h >> 17) & 3)
+    bitrate_index = (h >> 12) & 15
+    rate_index = (h >> 10) & 3
+    padding = (h >> 9) & 1
+    if version == 1 or layer == 4 or bitrate_index in (0, 15) or rate_index == 3:
+        return None
+    mpeg1 = version == 3
+    bitrate = MP3_BITRATES[(mpeg1, layer)][bitrate_index] * 1000
+    rate = MP3_SAMPLE_RATES[version][rate_index]
+    if layer == 1:
+        return (12 * bitrate // rate + padding) * 4, 384, rate
+    if layer == 2 or mpeg1:
+        return 144 * bitrate // rate + padding, 1152, rate
+    return 72 * bitrate // rate + padding, 576, rate
+
+
+def mp3_duration(data):
+    pos = 0
+    if data[:3] == b"ID3":
+        size = 0
+        for b in data[6:10]:
+            size = (size << 7) | (b & 0x7F)
+        pos = 10 + size + (10 if data[5] & 0x10 else 0)
+
+    seconds = 0.0
+    frames = 0
+    while pos < len(data):
+        frame = mp3_frame(data, pos)
+        # Only trust a frame if the next one follows (or the file ends).
+        if frame and (
+            pos + frame[0] >= len(data) - 128 or mp3_frame(data, pos + frame[0])
+        ):
+            body = data[pos : pos + frame[0]]
+            # A leading Xing/Info frame carries VBR metadata, no audio.
+            if frames > 0 or (b"Xing" not in body and b"Info" not in body):
+                seconds += frame[1] / frame[2]
+            frames += 1
+            pos += frame[0]
+        else:
+            pos += 1
+    if frames == 0:
+        raise ManifestError("no MPEG audio frames")
+    return seconds
+
+
+def collect_clips():
+    clips = []
+    errors = []
+    for folder_dir in sorted(glob.glob(os.path.join(SOUNDS_DIR, "[0-9][0-9]"))):
+        folder = int(os.path.basename(folder_dir))
+        tracks = {}
+        for path in sorted(glob.glob(os.path.join(folder_dir, "*"))):
+            rel = os.path.relpath(path, ROOT)
+            m = FILE_NAME.match(os.path.basename(path))
+            if not m:
+                errors.append(f"{rel}: not a playable NNN_name.mp3/wav file")
+                continue
+            track = int(m.group(1))
+            name = m.group(2)
+            if track in tracks:
+                errors.append(f"{rel}: track {track} already used by {tracks[track]}")
+                continue
+            tracks[track] = rel
+
+            if "__" in name:
+                category = name.split("__")[0]
+            else:
+                category = FOLDER_CATEGORIES.get(folder)
+            if category not in CATEGORIES:
+                errors.append(f"{rel}: unknown category {category}")
+                continue
+
+            with open(path, "rb") as f:
+                data = f.read()
+            try:
+                if m.group(3).lower() == "wav":
+                    seconds = wav_duration(data)
+                else:
+                    seconds = mp3_duration(data)
+            except ManifestError as e:
+                errors.append(f"{rel}: {e}")
+                continue
+            clips.append(
+                {
+                    "path": rel,
+                    "folder": folder,
+                    "track": track,
+                    "category": category,
+                    "duration_ms": min(round(seconds * 1000), 0xFFFF),
+                    "size": len(data),
+                }
+            )
+    return clips, errors
+
+
+def render(clips):
+    # Grouped by category, so that a category is a contiguous range.
+    clips = sorted(
+        clips, key=lambda c: (CATEGORIES.index(c["category"]), c["folder"], c["track"])
+    )
+    by_id = sorted(range(len(clips)), key=lambda i: (clips[i]["folder"], clips[i]["track"]))
+
+    out = []
+    w = out.append
+    w("#pragma once")
+    w("")
+    w("// Generated by generate-sound-manifest.py from sounds/, do not edit.")
+    w("")
+    w('#include "sound_clip.h"')
+    w("")
+    w("enum class SoundCategory : uint8_t {")
+    for c in CATEGORIES:
+        w(f"  {c},")
+    w("  Count")
+    w("};")
+    w("")
+    w("namespace sound_manifest {")
+    w("")
+    w("// Grouped by category.")
+    w("inline constexpr SoundClip clips[] = {")
+    for c in clips:
+        w(
+            f"    {{{c['folder']}, {c['track']}, SoundCategory::{c['category']}, "
+            f"{c['duration_ms']}, {c['size']}}}, // {c['path']}"
+        )
+    if not clips:
+        w("    {0, 0, SoundCategory::phone, 0, 0},")
+    w("};")
+    w("inline constexpr uint16_t clip_count = " + str(len(clips)) + ";")
+    w("")
+    w("// [first, end) in clips per category.")
+    w("inline constexpr SoundCategoryRange categories[] = {")
+    for cat in CATEGORIES:
+        idx = [i for i, c in enumerate(clips) if c["category"] == cat]
+        first = idx[0] if idx else 0
+        w(f"    {{{first}, {first + len(idx)}}}, // {cat}")
+    w("};")
+    w("")
+    w("// Indices into clips, sorted by folder and track.")
+    w("inline constexpr uint16_t by_id[] = {")
+    line = "   "
+    for i in by_id:
+        item = f" {i},"
+        if len(line) + len(item) > 80:
+            w(line)
+            line = "   "
+        line += item
+    if not by_id:
+        line += " 0,"
+    w(line)
+    w("};")
+    w("")
+    w("} // namespace sound_manifest")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument(
+        "--check",
+        action="store_true",
+        help="verify that sound_manifest.h matches the files",
+    )
+    parser.add_argument("--output", default=MANIFEST)
+    args = parser.parse_args()
+
+    clips, errors = collect_clips()
+    for e in errors:
+        print(f"error: {e}", file=sys.stderr)
+    text = render(clips)
+
+    if args.check:
+        try:
+            with open(args.output) as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = None
+        if current != text:
+            print(
+                f"{os.path.relpath(args.output)} is out of date, "
+                "run ./generate-sound-manifest.py",
+                file=sys.stderr,
+            )
+            sys.exit(1)
+        if errors:
+            sys.exit(1)
+        print(f"{len(clips)} clips, manifest up to date")
+        return
+
+    with open(args.output, "w") as f:
+        f.write(text)
+    print(f"{len(clips)} clips written to {os.path.relpath(args.output)}")
+    if errors:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
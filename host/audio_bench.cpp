@@ -0,0 +1,161 @@
+// Checks the ADPCM decoder and the mixer of the PWM audio output against
+// the reference encoder in generate-audio-clips.py and against a naive
+// mix, then measures their throughput.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "adpcm.h"
+#include "audio_clips.h"
+#include "audio_mixer.h"
+
+// Keep in sync with pwm_audio.h
+#define SAMPLE_RATE 22050
+#define BUFFER_SAMPLES 128
+
+namespace {
+
+auto crc32(const int16_t *samples, size_t count) -> uint32_t {
+  uint32_t crc = 0xffffffff;
+  auto const *bytes = reinterpret_cast<const uint8_t *>(samples);
+  for (size_t i = 0; i < 2 * count; ++i) {
+    crc ^= bytes[i];
+    for (int k = 0; k < 8; ++k) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+auto decode_all(AdpcmClip const &clip) -> std::vector<int16_t> {
+  std::vector<int16_t> pcm(clip.samples);
+  AdpcmDecoder decoder;
+  decoder.decode(clip, 0, pcm.data(), pcm.size());
+  return pcm;
+}
+
+auto check_decoder() -> bool {
+  bool ok = true;
+  for (auto const &check : audio_clips::checks) {
+    auto const pcm = decode_all(*check.clip);
+    uint32_t const crc = crc32(pcm.data(), pcm.size());
+    bool const match = crc == check.decoded_crc32;
+    std::printf("decode %-8s %6u samples  crc %08x  %s\n", check.name,
+                check.clip->samples, crc, match ? "ok" : "MISMATCH");
+    ok &= match;
+  }
+  return ok;
+}
+
+// Starts overlapping clips at odd offsets (more than AUDIO_VOICES, so that
+// voices are stolen) and compares with a straightforward mix.
+auto check_mixer() -> bool {
+  struct Start {
+    AdpcmClip const *clip;
+    uint16_t volume;
+    size_t at;
+  };
+  std::vector<Start> const starts = {
+      {&audio_clips::digit_3, 256, 0},    {&audio_clips::blip, 128, 77},
+      {&audio_clips::digit_7, 200, 1000}, {&audio_clips::click, 256, 1001},
+      {&audio_clips::blop, 256, 3333},    {&audio_clips::digit_1, 90, 5000},
+  };
+  size_t const total = 40000;
+
+  // Which start occupies which voice, as AudioMixer::play() picks them.
+  std::vector<int32_t> expected(total, 0);
+  struct Voice {
+    int start = -1;
+    size_t begin = 0;
+  } voices[AUDIO_VOICES];
+  std::vector<size_t> end(starts.size(), 0);
+  for (size_t s = 0; s < starts.size(); ++s) {
+    auto const at = starts[s].at;
+    Voice *voice = &voices[0];
+    for (auto &v : voices) {
+      bool const free =
+          v.start < 0 || v.begin + starts[v.start].clip->samples <= at;
+      if (free) {
+        voice = &v;
+        break;
+      }
+      if (v.begin < voice->begin)
+        voice = &v;
+    }
+    if (voice->start >= 0)
+      end[voice->start] = std::min(end[voice->start], at);
+    voice->start = s;
+    voice->begin = at;
+    end[s] = at + starts[s].clip->samples;
+  }
+  for (size_t s = 0; s < starts.size(); ++s) {
+    auto const pcm = decode_all(*starts[s].clip);
+    for (size_t i = starts[s].at; i < std::min(end[s], total); ++i) {
+      expected[i] += (pcm[i - starts[s].at] * starts[s].volume) >> 8;
+    }
+  }
+
+  AudioMixer mixer;
+  std::vector<int16_t> out(total);
+  size_t pos = 0;
+  size_t next = 0;
+  while (pos < total) {
+    while (next < starts.size() && starts[next].at == pos) {
+      mixer.play(*starts[next].clip, starts[next].volume);
+      next++;
+    }
+    size_t n = std::min<size_t>(101, total - pos);
+    if (next < starts.size())
+      n = std::min(n, starts[next].at - pos);
+    mixer.mix(&out[pos], n);
+    pos += n;
+  }
+
+  size_t bad = 0;
+  for (size_t i = 0; i < total; ++i) {
+    int32_t const e = std::clamp(expected[i], -32768, 32767);
+    bad += out[i] != e;
+  }
+  std::printf("mix    %zu samples, %zu mismatches  %s\n", total, bad,
+              bad ? "MISMATCH" : "ok");
+  return bad == 0;
+}
+
+auto bench() -> void {
+  using Clock = std::chrono::steady_clock;
+  size_t const seconds = 60;
+  int16_t buffer[BUFFER_SAMPLES];
+
+  for (int voices = 0; voices <= AUDIO_VOICES; ++voices) {
+    AudioMixer mixer;
+    size_t samples = 0;
+    auto const start = Clock::now();
+    while (samples < seconds * SAMPLE_RATE) {
+      if (mixer.active_voices() < voices) {
+        mixer.play(audio_clips::digit_5, 256);
+        continue;
+      }
+      mixer.mix(buffer, BUFFER_SAMPLES);
+      samples += BUFFER_SAMPLES;
+    }
+    double const elapsed =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("bench  %d voices: %6.1f Msamples/s, %7.0fx real time, "
+                "%.2f us per %d sample buffer\n",
+                voices, samples / elapsed / 1e6,
+                samples / elapsed / SAMPLE_RATE,
+                elapsed / (samples / BUFFER_SAMPLES) * 1e6, BUFFER_SAMPLES);
+  }
+}
+
+} // namespace
+
+int main() {
+  bool ok = check_decoder();
+  ok &= check_mixer();
+  bench();
+  return ok ? 0 : 1;
+}
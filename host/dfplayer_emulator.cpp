@@ -0,0 +1,238 @@
+#include "dfplayer_emulator.h"
+
+#include <cstdint>
+
+#include "dfplayer_protocol.h"
+#include "sound_manifest.h"
+
+// Commands, see the DFPlayer Mini manual.
+#define CMD_NEXT 0x01
+#define CMD_PREVIOUS 0x02
+#define CMD_PLAY_TRACK 0x03
+#define CMD_VOLUME 0x06
+#define CMD_EQ 0x07
+#define CMD_RESET 0x0C
+#define CMD_RESUME 0x0D
+#define CMD_PAUSE 0x0E
+#define CMD_PLAY_FOLDER_TRACK 0x0F
+#define CMD_STOP 0x16
+#define CMD_QUERY_STATUS 0x42
+#define CMD_QUERY_VOLUME 0x43
+#define CMD_QUERY_SD_TRACKS 0x48
+#define CMD_QUERY_SD_CURRENT 0x4C
+#define CMD_QUERY_FOLDER_TRACKS 0x4E
+
+// Responses
+#define RSP_SD_FINISHED 0x3D
+#define RSP_INIT_COMPLETE 0x3F
+#define RSP_ERROR 0x40
+#define RSP_ACK 0x41
+
+#define STORAGE_SD 0x02
+
+DfPlayerEmulator::DfPlayerEmulator() : DfPlayerEmulator(Options()) {}
+
+DfPlayerEmulator::DfPlayerEmulator(Options const &options)
+    : options_(options) {
+  // Powering up behaves like a reset.
+  reset(0);
+}
+
+auto DfPlayerEmulator::reset(uint64_t now_us) -> void {
+  initialized_ = false;
+  init_done_us_ = now_us + options_.init_ms * 1000ull;
+  playback_ = Playback::Stopped;
+  volume_ = 30;
+  eq_ = 0;
+  // A reset drops whatever was about to be sent, except for the byte on
+  // the line.
+  while (replies_.size() > (reply_sent_ ? 1 : 0)) {
+    replies_.pop_back();
+  }
+  reply(RSP_INIT_COMPLETE, STORAGE_SD, init_done_us_);
+}
+
+auto DfPlayerEmulator::receive(uint8_t byte, uint64_t now_us) -> void {
+  update(now_us);
+  if (length_ == 0 && byte != 0x7E)
+    return;
+  frame_[length_++] = byte;
+  bool const bad_header = (length_ == 2 && byte != 0xFF) ||
+                          (length_ == 3 && byte != 0x06);
+  if (bad_header) {
+    stats_.framing_errors++;
+    length_ = byte == 0x7E ? 1 : 0;
+    if (length_)
+      frame_[0] = byte;
+    return;
+  }
+  if (length_ < DFPLAYER_FRAME_SIZE)
+    return;
+
+  length_ = 0;
+  if (byte != 0xEF) {
+    stats_.framing_errors++;
+    return;
+  }
+  if (((frame_[7] << 8) | frame_[8]) != dfplayer_checksum(frame_)) {
+    stats_.checksum_errors++;
+    error(DfPlayerEvent::ErrorChecksum, now_us);
+    return;
+  }
+
+  stats_.frames++;
+  uint8_t const cmd = frame_[DFPLAYER_FRAME_CMD];
+  uint16_t const param = (frame_[5] << 8) | frame_[6];
+  if (!initialized_ && cmd != CMD_RESET) {
+    stats_.busy++;
+    error(DfPlayerEvent::ErrorBusy, now_us);
+    return;
+  }
+  if (execute(cmd, param, now_us) && frame_[4]) {
+    reply(RSP_ACK, 0, now_us + options_.reply_us);
+  }
+}
+
+// Returns false if the command failed (and an error was sent).
+auto DfPlayerEmulator::execute(uint8_t cmd, uint16_t param, uint64_t now_us)
+    -> bool {
+  uint64_t const reply_us = now_us + options_.reply_us;
+  switch (cmd) {
+  case CMD_NEXT:
+    return play((index_ + 1) % sound_manifest::clip_count, now_us);
+  case CMD_PREVIOUS:
+    return play((index_ + sound_manifest::clip_count - 1) %
+                    sound_manifest::clip_count,
+                now_us);
+  case CMD_PLAY_TRACK:
+    if (param == 0 || param > sound_manifest::clip_count) {
+      stats_.not_found++;
+      error(DfPlayerEvent::ErrorTrackOutOfRange, now_us);
+      return false;
+    }
+    return play(param - 1, now_us);
+  case CMD_PLAY_FOLDER_TRACK:
+    for (uint16_t i = 0; i < sound_manifest::clip_count; ++i) {
+      auto const &clip = sound_manifest::clips[sound_manifest::by_id[i]];
+      if (clip.folder == param >> 8 && clip.track == (param & 0xff))
+        return play(i, now_us);
+    }
+    stats_.not_found++;
+    error(DfPlayerEvent::ErrorTrackNotFound, now_us);
+    return false;
+  case CMD_VOLUME:
+    volume_ = param > 30 ? 30 : param;
+    return true;
+  case CMD_EQ:
+    eq_ = param;
+    return true;
+  case CMD_RESET:
+    reset(now_us);
+    return true;
+  case CMD_PAUSE:
+    if (playback_ == Playback::Playing) {
+      playback_ = Playback::Paused;
+      end_us_ = end_us_ > now_us ? end_us_ - now_us : 0;
+    }
+    return true;
+  case CMD_RESUME:
+    if (playback_ == Playback::Paused) {
+      playback_ = Playback::Playing;
+      end_us_ += now_us;
+    }
+    return true;
+  case CMD_STOP:
+    playback_ = Playback::Stopped;
+    return true;
+  case CMD_QUERY_STATUS:
+    reply(CMD_QUERY_STATUS,
+          (STORAGE_SD << 8) | static_cast<uint8_t>(playback_), reply_us);
+    return true;
+  case CMD_QUERY_VOLUME:
+    reply(CMD_QUERY_VOLUME, volume_, reply_us);
+    return true;
+  case CMD_QUERY_SD_TRACKS:
+    reply(CMD_QUERY_SD_TRACKS, sound_manifest::clip_count, reply_us);
+    return true;
+  case CMD_QUERY_SD_CURRENT:
+    reply(CMD_QUERY_SD_CURRENT, index_ + 1, reply_us);
+    return true;
+  case CMD_QUERY_FOLDER_TRACKS: {
+    uint16_t count = 0;
+    for (auto const &clip : sound_manifest::clips) {
+      count += clip.folder == param;
+    }
+    reply(CMD_QUERY_FOLDER_TRACKS, count, reply_us);
+    return true;
+  }
+  default:
+    error(DfPlayerEvent::ErrorSerialData, now_us);
+    return false;
+  }
+}
+
+auto DfPlayerEmulator::play(uint16_t index, uint64_t now_us) -> bool {
+  auto const &clip = sound_manifest::clips[sound_manifest::by_id[index]];
+  index_ = index;
+  folder_ = clip.folder;
+  track_ = clip.track;
+  playback_ = Playback::Playing;
+  start_us_ = now_us + options_.start_ms * 1000ull;
+  end_us_ = start_us_ + clip.duration_ms * 1000ull;
+  stats_.started++;
+  return true;
+}
+
+auto DfPlayerEmulator::reply(uint8_t cmd, uint16_t param, uint64_t due_us)
+    -> void {
+  Reply r;
+  r.due_us = due_us;
+  dfplayer_make_frame(r.frame, cmd, param);
+  // Keep the replies ordered by time, the init message may be due late.
+  auto it = replies_.end();
+  while (it != replies_.begin() && (it - 1)->due_us > due_us &&
+         !(it - 1 == replies_.begin() && reply_sent_)) {
+    --it;
+  }
+  replies_.insert(it, r);
+}
+
+auto DfPlayerEmulator::error(uint16_t code, uint64_t now_us) -> void {
+  reply(RSP_ERROR, code, now_us + options_.reply_us);
+}
+
+auto DfPlayerEmulator::update(uint64_t now_us) -> void {
+  if (!initialized_ && now_us >= init_done_us_) {
+    initialized_ = true;
+  }
+  if (playback_ == Playback::Playing && now_us >= end_us_) {
+    playback_ = Playback::Stopped;
+    stats_.finished++;
+    reply(RSP_SD_FINISHED, index_ + 1, end_us_);
+  }
+}
+
+auto DfPlayerEmulator::transmit(uint64_t now_us, uint8_t &byte) -> bool {
+  update(now_us);
+  if (replies_.empty() || replies_.front().due_us > now_us)
+    return false;
+  auto &r = replies_.front();
+  byte = r.frame[reply_sent_++];
+  if (reply_sent_ == DFPLAYER_FRAME_SIZE) {
+    replies_.pop_front();
+    reply_sent_ = 0;
+    stats_.replies++;
+  }
+  return true;
+}
+
+auto DfPlayerEmulator::next_event_us() const -> uint64_t {
+  uint64_t next = UINT64_MAX;
+  if (!initialized_)
+    next = init_done_us_;
+  if (playback_ == Playback::Playing && end_us_ < next)
+    next = end_us_;
+  if (!replies_.empty() && replies_.front().due_us < next)
+    next = replies_.front().due_us;
+  return next;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "dfplayer_queue.h"
+
+// At 9600 baud 8N1 a byte is 10 bits on the line.
+#define DFPLAYER_BAUDRATE 9600
+#define DFPLAYER_BYTE_US (10 * 1000000 / DFPLAYER_BAUDRATE)
+
+// A stand-in for the DFPlayer Mini on the far end of the host UART (see
+// host_board.h).
+//
+// It checks the command frames byte by byte, plays the files listed in
+// sound_manifest.h for their real duration and answers like the module
+// does: 0x3F once initialized, 0x3D when a track is finished, 0x40 on
+// errors, 0x41 if a command asks for feedback and the query responses.
+// Commands sent before the module is initialized are rejected as busy.
+class DfPlayerEmulator {
+public:
+  struct Options {
+    // The modules seen so far take 1-3 s after a reset.
+    uint32_t init_ms = 1500;
+    // Time from the end of a command frame to its response.
+    uint32_t reply_us = 5000;
+    // Time from a play command to the start of the audio.
+    uint32_t start_ms = 20;
+  };
+
+  struct Stats {
+    uint32_t frames = 0;
+    uint32_t framing_errors = 0;
+    uint32_t checksum_errors = 0;
+    uint32_t busy = 0;
+    uint32_t not_found = 0;
+    uint32_t started = 0;
+    uint32_t finished = 0;
+    uint32_t replies = 0;
+  };
+
+  enum class Playback : uint8_t { Stopped, Playing, Paused };
+
+  DfPlayerEmulator();
+  explicit DfPlayerEmulator(Options const &options);
+
+  // A byte has arrived completely on the module's RX line.
+  auto receive(uint8_t byte, uint64_t now_us) -> void;
+  // The next byte to send, if one is due.
+  auto transmit(uint64_t now_us, uint8_t &byte) -> bool;
+  // When transmit() or the playback state change next, UINT64_MAX if
+  // nothing is pending.
+  auto next_event_us() const -> uint64_t;
+  auto update(uint64_t now_us) -> void;
+
+  auto initialized() const -> bool { return initialized_; }
+  auto playback() const -> Playback { return playback_; }
+  auto folder() const -> uint8_t { return folder_; }
+  auto track() const -> uint8_t { return track_; }
+  auto volume() const -> uint8_t { return volume_; }
+  auto stats() const -> Stats const & { return stats_; }
+
+private:
+  struct Reply {
+    uint64_t due_us;
+    uint8_t frame[DFPLAYER_FRAME_SIZE];
+  };
+
+  auto execute(uint8_t cmd, uint16_t param, uint64_t now_us) -> bool;
+  auto play(uint16_t index, uint64_t now_us) -> bool;
+  auto reply(uint8_t cmd, uint16_t param, uint64_t due_us) -> void;
+  auto error(uint16_t code, uint64_t now_us) -> void;
+  auto reset(uint64_t now_us) -> void;
+
+  Options options_;
+  Stats stats_;
+
+  uint8_t frame_[DFPLAYER_FRAME_SIZE];
+  uint8_t length_ = 0;
+  std::deque<Reply> replies_;
+  uint8_t reply_sent_ = 0;
+
+  bool initialized_ = false;
+  uint64_t init_done_us_ = 0;
+
+  Playback playback_ = Playback::Stopped;
+  // Index into sound_manifest::by_id, the file's number on the SD card.
+  uint16_t index_ = 0;
+  uint8_t folder_ = 0;
+  uint8_t track_ = 0;
+  uint64_t start_us_ = 0;
+  // Playing time left when paused, else the end of the track.
+  uint64_t end_us_ = 0;
+  uint8_t volume_ = 30;
+  uint8_t eq_ = 0;
+};
@@ -0,0 +1,263 @@
+// Runs the firmware's DFPlayer driver (dfPlayerDriver.h) and sound arbiter
+// against DfPlayerEmulator on the virtual board of host_board.h. Checks
+// the protocol and reports what the audio commands cost the frame loop.
+// Exits non-zero if a check fails.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "dfPlayerDriver.h"
+#include "dfplayer_emulator.h"
+#include "host_board.h"
+#include "sound_arbiter.h"
+#include "sound_clip.h"
+#include "sound_manifest.h"
+
+// As in busyboard.cpp
+#define DFPLAYER_UART 1
+#define DFPLAYER_INIT_TIMEOUT_MS 3000
+#define DFPLAYER_MINI_RX 8
+#define DFPLAYER_MINI_TX 9
+#define FRAME_US 16667
+
+#define SIM_STEP_US 100
+#define SIM_LOAD_SECONDS 120
+
+namespace {
+
+using Player = DfPlayerPico<DFPLAYER_UART, DFPLAYER_MINI_TX, DFPLAYER_MINI_RX>;
+using Clock = std::chrono::steady_clock;
+
+int failures = 0;
+
+auto check(bool ok, const char *what) -> void {
+  if (!ok) {
+    std::printf("FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// Time spent in the firmware's code, as opposed to the emulator's.
+struct FirmwareTime {
+  double send_ns = 0;
+  uint32_t sends = 0;
+  double poll_ns = 0;
+  uint32_t polls = 0;
+};
+FirmwareTime firmware_time;
+
+auto play_sound(Player &dfp, uint8_t folder, uint8_t track) -> void {
+  auto const start = Clock::now();
+  dfp.sendCmd(dfPlayer::SPECIFY_FOLDER_PLAYBACK, (folder << 8) | track);
+  firmware_time.send_ns +=
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  firmware_time.sends++;
+}
+
+// Polls the events like poll_dfplayer() in busyboard.cpp; returns the
+// number of TrackFinished events.
+auto poll(Player &dfp, uint32_t *errors = nullptr) -> uint32_t {
+  uint32_t finished = 0;
+  DfPlayerEvent event;
+  auto const start = Clock::now();
+  while (dfp.pollEvent(event)) {
+    if (event.type == DfPlayerEvent::Type::TrackFinished)
+      finished++;
+    if (event.type == DfPlayerEvent::Type::Error && errors)
+      *errors = event.param;
+  }
+  firmware_time.poll_ns +=
+      std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  firmware_time.polls++;
+  return finished;
+}
+
+auto boot(Player &dfp, DfPlayerEmulator &emulator) -> void {
+  auto const start = host_board::now_us();
+  dfp.reset();
+  bool const ready =
+      dfp.waitFor(DfPlayerEvent::Type::InitComplete, DFPLAYER_INIT_TIMEOUT_MS);
+  std::printf("init      %s after %.1f ms\n", ready ? "complete" : "TIMEOUT",
+              (host_board::now_us() - start) / 1000.0);
+  check(ready && dfp.ready() && emulator.initialized(), "init");
+
+  dfp.specifyVolume(15);
+  host_board::advance_us(20 * DFPLAYER_BYTE_US);
+  check(emulator.volume() == 15, "volume");
+}
+
+// Plays every file of the manifest and waits for it to finish.
+auto play_all(Player &dfp, DfPlayerEmulator &emulator) -> void {
+  uint32_t max_latency_us = 0;
+  int32_t max_duration_error_ms = 0;
+  for (uint16_t i = 0; i < sound_manifest::clip_count; ++i) {
+    auto const &clip = sound_manifest::clips[i];
+    auto const frames = emulator.stats().frames;
+    auto const start = host_board::now_us();
+    play_sound(dfp, clip.folder, clip.track);
+
+    while (emulator.stats().frames == frames) {
+      host_board::advance_us(SIM_STEP_US);
+    }
+    max_latency_us =
+        std::max<uint32_t>(max_latency_us, host_board::now_us() - start);
+    check(emulator.folder() == clip.folder && emulator.track() == clip.track,
+          "played the requested file");
+    check(dfp.playing(), "playing() after a play command");
+
+    uint32_t finished = 0;
+    while (!finished && host_board::now_us() - start < 60000000) {
+      host_board::advance_us(FRAME_US);
+      finished += poll(dfp);
+    }
+    check(finished == 1, "one TrackFinished per track");
+    check(!dfp.playing(), "not playing() after TrackFinished");
+    int32_t const played_ms = (host_board::now_us() - start) / 1000;
+    max_duration_error_ms =
+        std::max(max_duration_error_ms,
+                 std::abs(played_ms - static_cast<int32_t>(clip.duration_ms)));
+  }
+  std::printf("play      %u files, command latency max %.1f ms, finish "
+              "detected within %d ms of the duration\n",
+              sound_manifest::clip_count, max_latency_us / 1000.0,
+              max_duration_error_ms);
+  // A frame on the line, plus the byte the emulator needs to see the end.
+  check(max_latency_us <= 11 * DFPLAYER_BYTE_US + SIM_STEP_US,
+        "command latency");
+}
+
+// Requests in a burst are coalesced in the driver's queue. Only the first
+// one goes out right away, since the UART was idle; the others replace
+// each other until it is done, so the latest one is started next.
+auto burst(Player &dfp, DfPlayerEmulator &emulator) -> void {
+  auto const started = emulator.stats().started;
+  auto const coalesced = dfp.txStats().coalesced;
+  auto const &last = sound_manifest::clips[sound_manifest::clip_count - 1];
+  for (int i = 0; i < 6; ++i) {
+    play_sound(dfp, sound_manifest::clips[i].folder,
+               sound_manifest::clips[i].track);
+  }
+  play_sound(dfp, last.folder, last.track);
+  while (!host_board::tx_idle()) {
+    host_board::advance_us(SIM_STEP_US);
+  }
+  host_board::advance_us(DFPLAYER_BYTE_US);
+  std::printf("burst     7 commands, %u coalesced, %u started\n",
+              dfp.txStats().coalesced - coalesced,
+              emulator.stats().started - started);
+  check(emulator.stats().started - started == 2, "burst coalesced");
+  check(dfp.txStats().coalesced - coalesced == 5, "burst kept one request");
+  check(emulator.folder() == last.folder && emulator.track() == last.track,
+        "burst plays the latest request");
+
+  dfp.sendCmd(0x16, 0); // stop
+  host_board::advance_us(FRAME_US);
+  poll(dfp);
+
+  // A play that waits behind a pause must not be moved ahead of it: the
+  // first play goes out, the second is dropped for the third, which is
+  // sent after the pause.
+  auto const &first = sound_manifest::clips[0];
+  auto const &second = sound_manifest::clips[1];
+  auto const coalesced_before = dfp.txStats().coalesced;
+  play_sound(dfp, first.folder, first.track);
+  play_sound(dfp, second.folder, second.track);
+  dfp.sendCmd(0x0E, 0); // pause
+  play_sound(dfp, last.folder, last.track);
+  while (!host_board::tx_idle()) {
+    host_board::advance_us(SIM_STEP_US);
+  }
+  host_board::advance_us(DFPLAYER_BYTE_US);
+  check(dfp.txStats().coalesced - coalesced_before == 1,
+        "play after pause coalesced");
+  check(emulator.playback() == DfPlayerEmulator::Playback::Playing &&
+            emulator.folder() == last.folder && emulator.track() == last.track,
+        "play after pause keeps the order");
+
+  dfp.sendCmd(0x16, 0); // stop
+  host_board::advance_us(FRAME_US);
+  poll(dfp);
+}
+
+auto missing(Player &dfp) -> void {
+  uint32_t error = 0;
+  play_sound(dfp, 99, 1);
+  for (int i = 0; i < 3; ++i) {
+    host_board::advance_us(FRAME_US);
+    poll(dfp, &error);
+  }
+  std::printf("missing   error %u\n", error);
+  check(error == DfPlayerEvent::ErrorTrackNotFound, "track not found");
+  check(!dfp.playing(), "not playing() after an error");
+}
+
+// The frame loop of busyboard.cpp with random requests from all sources.
+auto load(Player &dfp, DfPlayerEmulator &emulator) -> void {
+  SoundArbiter arbiter;
+  firmware_time = {};
+  auto const uart = host_board::uart_stats();
+  uint32_t const frames = SIM_LOAD_SECONDS * 1000000 / FRAME_US;
+  std::srand(1);
+  for (uint32_t f = 0; f < frames; ++f) {
+    uint32_t const now_ms = host_board::now_us() / 1000;
+    for (int s = 0; s < static_cast<int>(SoundSource::Count); ++s) {
+      // About one request per source and second.
+      if (std::rand() % 60)
+        continue;
+      auto const &clip =
+          sound_manifest::clips[std::rand() % sound_manifest::clip_count];
+      arbiter.request(static_cast<SoundSource>(s), clip.folder, clip.track,
+                      clip.duration_ms, now_ms);
+    }
+    if (auto const sound = arbiter.update(now_ms, dfp.playing())) {
+      play_sound(dfp, sound->folder, sound->track);
+    }
+    poll(dfp);
+    host_board::advance_us(FRAME_US);
+  }
+
+  auto const &after = host_board::uart_stats();
+  auto const irqs = after.irqs - uart.irqs;
+  auto const bytes = after.tx_bytes - uart.tx_bytes + after.rx_bytes -
+                     uart.rx_bytes;
+  std::printf("load      %u frames, %u commands, %u played, %u preempted, "
+              "%u expired\n",
+              frames, firmware_time.sends, arbiter.stats().played,
+              arbiter.stats().preempted, arbiter.stats().expired);
+  std::printf("cost      %.2f UART interrupts and %.1f bytes per command, "
+              "max TX FIFO %u\n",
+              static_cast<double>(irqs) / firmware_time.sends,
+              static_cast<double>(bytes) / firmware_time.sends,
+              after.max_tx_fifo);
+  std::printf("cost      host time: %.0f ns per command, %.0f ns per poll\n",
+              firmware_time.send_ns / firmware_time.sends,
+              firmware_time.poll_ns / firmware_time.polls);
+  check(after.rx_overruns == 0, "no RX overruns");
+  check(dfp.rxDropped() == 0, "no dropped events");
+  check(dfp.parser().checksum_errors() == 0 &&
+            dfp.parser().framing_errors() == 0,
+        "replies parsed");
+  check(emulator.stats().checksum_errors == 0 &&
+            emulator.stats().framing_errors == 0,
+        "commands parsed");
+  check(emulator.stats().busy == 0, "no commands while busy");
+}
+
+} // namespace
+
+int main() {
+  DfPlayerEmulator emulator;
+  host_board::attach(&emulator);
+  Player dfp;
+
+  boot(dfp, emulator);
+  play_all(dfp, emulator);
+  burst(dfp, emulator);
+  missing(dfp);
+  load(dfp, emulator);
+
+  std::printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
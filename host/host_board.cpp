@@ -0,0 +1,241 @@
+#include "host_board.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+
+#include "dfplayer_emulator.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+#define UART_FIFO_SIZE 32
+#define UART_RX_TIMEOUT_US (32 * DFPLAYER_BYTE_US / 10)
+#define TIGHT_LOOP_US 10
+
+struct uart_inst {
+  int index;
+};
+
+namespace {
+uart_inst uart_instances[2] = {{0}, {1}};
+// UARTIFLS after reset: both levels at 1/2.
+uart_hw_t uart1_hw = {0, 0x12, 0};
+
+uint64_t now = 0;
+DfPlayerEmulator *emulator = nullptr;
+host_board::UartStats stats;
+
+// The UART is uart1 as in busyboard.cpp, uart0 (stdio) is ignored.
+std::deque<uint8_t> tx_fifo;
+bool tx_shifting = false;
+uint8_t tx_byte = 0;
+uint64_t tx_done = 0;
+
+std::deque<uint8_t> rx_fifo;
+bool rx_shifting = false;
+uint8_t rx_byte = 0;
+uint64_t rx_done = 0;
+uint64_t rx_last = 0;
+
+bool rx_irq = false;
+bool tx_irq = false;
+bool irq_enabled = false;
+irq_handler_t irq_handler = nullptr;
+bool interrupts_disabled = false;
+bool in_irq = false;
+
+auto start_tx() -> void {
+  if (tx_shifting || tx_fifo.empty())
+    return;
+  tx_byte = tx_fifo.front();
+  tx_fifo.pop_front();
+  tx_shifting = true;
+  tx_done = now + DFPLAYER_BYTE_US;
+}
+
+auto start_rx() -> void {
+  if (rx_shifting || !emulator || !emulator->transmit(now, rx_byte))
+    return;
+  rx_shifting = true;
+  rx_done = now + DFPLAYER_BYTE_US;
+}
+
+// The TX interrupt level in bytes, from UARTIFLS.TXIFLSEL.
+auto tx_level() -> size_t {
+  constexpr size_t levels[] = {4, 8, 16, 24, 28};
+  return levels[std::min<uint32_t>(uart1_hw.ifls & 7, 4)];
+}
+
+auto irq_pending() -> bool {
+  bool const rx = rx_irq && !rx_fifo.empty() &&
+                  (rx_fifo.size() >= UART_FIFO_SIZE / 2 ||
+                   now >= rx_last + UART_RX_TIMEOUT_US);
+  bool const tx = tx_irq && tx_fifo.size() <= tx_level();
+  return rx || tx;
+}
+
+auto run_irq() -> void {
+  if (!irq_enabled || !irq_handler || interrupts_disabled || in_irq)
+    return;
+  // The handler has to clear the condition; a level triggered interrupt
+  // that stays pending would hang the core.
+  for (int i = 0; i < 4 && irq_pending(); ++i) {
+    in_irq = true;
+    stats.irqs++;
+    irq_handler();
+    in_irq = false;
+  }
+}
+
+auto next_event() -> uint64_t {
+  uint64_t next = UINT64_MAX;
+  if (tx_shifting)
+    next = std::min(next, tx_done);
+  if (rx_shifting)
+    next = std::min(next, rx_done);
+  else if (emulator)
+    next = std::min(next, std::max(now, emulator->next_event_us()));
+  if (rx_irq && !rx_fifo.empty() && rx_last + UART_RX_TIMEOUT_US > now)
+    next = std::min(next, rx_last + UART_RX_TIMEOUT_US);
+  return next;
+}
+} // namespace
+
+uart_inst_t *const uart0 = &uart_instances[0];
+uart_inst_t *const uart1 = &uart_instances[1];
+
+namespace host_board {
+
+auto attach(DfPlayerEmulator *e) -> void { emulator = e; }
+
+auto now_us() -> uint64_t { return now; }
+
+auto advance_us(uint64_t us) -> void {
+  uint64_t const target = now + us;
+  while (true) {
+    run_irq();
+    start_tx();
+    start_rx();
+    uint64_t const next = next_event();
+    if (next > target)
+      break;
+    now = next;
+
+    if (tx_shifting && now >= tx_done) {
+      tx_shifting = false;
+      stats.tx_bytes++;
+      if (emulator)
+        emulator->receive(tx_byte, now);
+    }
+    if (rx_shifting && now >= rx_done) {
+      rx_shifting = false;
+      stats.rx_bytes++;
+      rx_last = now;
+      if (rx_fifo.size() < UART_FIFO_SIZE) {
+        rx_fifo.push_back(rx_byte);
+      } else {
+        stats.rx_overruns++;
+      }
+    }
+    if (emulator)
+      emulator->update(now);
+  }
+  now = target;
+  run_irq();
+}
+
+auto tx_idle() -> bool { return tx_fifo.empty() && !tx_shifting; }
+
+auto uart_stats() -> UartStats const & { return stats; }
+
+} // namespace host_board
+
+//----------------------------------------------------------------------------
+// pico_shim
+//----------------------------------------------------------------------------
+
+void gpio_set_function(uint, gpio_function) {}
+
+absolute_time_t get_absolute_time() { return now; }
+uint32_t to_ms_since_boot(absolute_time_t t) { return t / 1000; }
+absolute_time_t make_timeout_time_ms(uint32_t ms) { return now + ms * 1000ull; }
+bool time_reached(absolute_time_t t) { return now >= t; }
+uint32_t time_us_32() { return now; }
+uint64_t time_us_64() { return now; }
+void sleep_ms(uint32_t ms) { host_board::advance_us(ms * 1000ull); }
+void sleep_us(uint64_t us) { host_board::advance_us(us); }
+void tight_loop_contents() { host_board::advance_us(TIGHT_LOOP_US); }
+
+uint uart_init(uart_inst_t *, uint baudrate) { return baudrate; }
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx, bool tx) {
+  if (uart != uart1)
+    return;
+  rx_irq = rx;
+  tx_irq = tx;
+}
+
+uart_hw_t *uart_get_hw(uart_inst_t *) {
+  uart1_hw.fr = tx_fifo.empty() ? UART_UARTFR_TXFE_BITS : 0;
+  uart1_hw.ris = tx_fifo.size() <= tx_level() ? UART_UARTRIS_TXRIS_BITS : 0;
+  return &uart1_hw;
+}
+
+bool uart_is_writable(uart_inst_t *uart) {
+  return uart != uart1 || tx_fifo.size() < UART_FIFO_SIZE;
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+  return uart == uart1 && !rx_fifo.empty();
+}
+
+void uart_putc_raw(uart_inst_t *uart, char c) {
+  if (uart != uart1)
+    return;
+  // Like the PL011, a write to a full FIFO is lost.
+  if (tx_fifo.size() < UART_FIFO_SIZE)
+    tx_fifo.push_back(c);
+  stats.max_tx_fifo =
+      std::max<uint8_t>(stats.max_tx_fifo, tx_fifo.size());
+}
+
+char uart_getc(uart_inst_t *uart) {
+  while (!uart_is_readable(uart)) {
+    tight_loop_contents();
+  }
+  char const c = rx_fifo.front();
+  rx_fifo.pop_front();
+  return c;
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    while (!uart_is_writable(uart)) {
+      tight_loop_contents();
+    }
+    uart_putc_raw(uart, src[i]);
+  }
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+  if (num == UART1_IRQ)
+    irq_handler = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+  if (num == UART1_IRQ)
+    irq_enabled = enabled;
+}
+
+uint32_t save_and_disable_interrupts() {
+  bool const was = interrupts_disabled;
+  interrupts_disabled = true;
+  return was;
+}
+
+void restore_interrupts(uint32_t status) {
+  interrupts_disabled = status;
+  // A pending interrupt is taken as soon as it is unmasked.
+  run_irq();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+class DfPlayerEmulator;
+
+// The virtual board behind pico_shim/: a clock in microseconds and the
+// UART with the DFPlayer on the other end.
+//
+// Time only moves in advance_us() (and in the busy waits of the shim).
+// Bytes take DFPLAYER_BYTE_US on the line in both directions and the UART
+// has 32 byte FIFOs like the RP2040's PL011, whose interrupt is modeled
+// with its thresholds: TX when the FIFO is at most at the UARTIFLS level
+// (half full after reset), RX when it is at least half full or when no
+// byte arrived for 32 bit times.
+namespace host_board {
+
+struct UartStats {
+  uint32_t irqs = 0;
+  uint32_t tx_bytes = 0;
+  uint32_t rx_bytes = 0;
+  uint32_t rx_overruns = 0;
+  uint8_t max_tx_fifo = 0;
+};
+
+auto attach(DfPlayerEmulator *emulator) -> void;
+
+auto now_us() -> uint64_t;
+// Runs the line, the emulator and the UART interrupt up to now + us.
+auto advance_us(uint64_t us) -> void;
+
+// Whether the firmware has bytes waiting in the TX FIFO or on the line.
+auto tx_idle() -> bool;
+auto uart_stats() -> UartStats const &;
+
+} // namespace host_board
@@ -0,0 +1,99 @@
+// Checks the generated microstep table (generate-microstep-table.py)
+// against the coil currents of the VID28-05 datasheet: the coil voltages
+// the three pins produce, U1 = pin 1 - pin 2/3 and U2 = pin 4 - pin 2/3,
+// have to follow the datasheet's table at the 24 microsteps.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "vid28_microsteps.h"
+
+#define MICROSTEPS 24
+#define SUBSTEPS (VID28_TABLE_SIZE / MICROSTEPS)
+// Largest deviation from the datasheet, in mA of a 15.3 mA peak.
+#define MAX_ERROR_MA 0.5
+
+static_assert(VID28_TABLE_SIZE % (2 * MICROSTEPS) == 0,
+              "the datasheet points have to fall on table entries");
+
+namespace {
+
+// VID Micro Step Calculation Table, peak at microstep 0.
+constexpr double datasheet_ma[] = {15.30, 14.80, 13.25, 9.75,
+                                   5.59,  2.85,  0.0};
+
+auto datasheet(int k) -> double {
+  k = ((k % MICROSTEPS) + MICROSTEPS) % MICROSTEPS;
+  if (k > MICROSTEPS / 2)
+    k = MICROSTEPS - k;
+  if (k > MICROSTEPS / 4)
+    return -datasheet_ma[MICROSTEPS / 2 - k];
+  return datasheet_ma[k];
+}
+
+auto coil(int pin, int entry) -> int {
+  entry %= VID28_TABLE_SIZE;
+  return vid28::pin_levels[pin][entry] - vid28::pin_levels[1][entry];
+}
+
+} // namespace
+
+int main() {
+  bool ok = true;
+
+  int max_delta = 0;
+  int min_sum = 3 * VID28_PWM_WRAP;
+  int max_sum = 0;
+  for (int i = 0; i < VID28_TABLE_SIZE; ++i) {
+    int sum = 0;
+    for (int p = 0; p < 3; ++p) {
+      int const level = vid28::pin_levels[p][i];
+      int const next = vid28::pin_levels[p][(i + 1) % VID28_TABLE_SIZE];
+      ok &= level >= 0 && level <= VID28_PWM_WRAP;
+      max_delta = std::max(max_delta, std::abs(next - level));
+      sum += level;
+    }
+    min_sum = std::min(min_sum, sum);
+    max_sum = std::max(max_sum, sum);
+  }
+  // The pins are centered around half the supply.
+  ok &= std::abs(min_sum - 3 * VID28_PWM_WRAP / 2) <= 3;
+  ok &= std::abs(max_sum - 3 * VID28_PWM_WRAP / 2) <= 3;
+
+  // The datasheet's microstep m is entry (m - 1/2) * SUBSTEPS; coil 2
+  // lags coil 1 by 4 microsteps. Scale the levels to mA by a least
+  // squares fit.
+  double uu = 0;
+  double ud = 0;
+  for (int m = 0; m < MICROSTEPS; ++m) {
+    int const entry = m * SUBSTEPS - SUBSTEPS / 2 + VID28_TABLE_SIZE;
+    for (int c = 0; c < 2; ++c) {
+      double const d = datasheet(m - 4 * c);
+      double const u = coil(c == 0 ? 0 : 2, entry);
+      uu += u * u;
+      ud += u * d;
+    }
+  }
+  double const ma_per_level = uu > 0 ? ud / uu : 0;
+
+  double max_error = 0;
+  for (int m = 0; m < MICROSTEPS; ++m) {
+    int const entry = m * SUBSTEPS - SUBSTEPS / 2 + VID28_TABLE_SIZE;
+    for (int c = 0; c < 2; ++c) {
+      double const u = coil(c == 0 ? 0 : 2, entry) * ma_per_level;
+      double const error = std::abs(u - datasheet(m - 4 * c));
+      max_error = std::max(max_error, error);
+    }
+  }
+  ok &= max_error <= MAX_ERROR_MA;
+  // Substeps have to be fine enough to matter.
+  ok &= max_delta <= 2 * VID28_PWM_WRAP / (VID28_TABLE_SIZE / 4);
+
+  std::printf("%d entries, wrap %d: max error %.2f mA, largest step %d, "
+              "pin sum %d..%d  %s\n",
+              VID28_TABLE_SIZE, VID28_PWM_WRAP, max_error, max_delta,
+              min_sum, max_sum, ok ? "ok" : "MISMATCH");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+typedef void (*irq_handler_t)(void);
+
+enum { UART0_IRQ = 20, UART1_IRQ = 21 };
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
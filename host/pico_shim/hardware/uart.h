@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+typedef struct uart_inst uart_inst_t;
+
+// The registers the driver uses directly; uart_get_hw() updates fr and ris.
+typedef struct {
+  uint32_t fr;
+  uint32_t ifls;
+  uint32_t ris;
+} uart_hw_t;
+
+#define UART_UARTFR_TXFE_BITS 0x00000080
+#define UART_UARTRIS_TXRIS_BITS 0x00000020
+#define UART_UARTIFLS_TXIFLSEL_BITS 0x00000007
+#define UART_UARTIFLS_TXIFLSEL_LSB 0
+
+uart_hw_t *uart_get_hw(uart_inst_t *uart);
+
+static inline void hw_write_masked(uint32_t *addr, uint32_t values,
+                                   uint32_t write_mask) {
+  *addr = (*addr & ~write_mask) | (values & write_mask);
+}
+extern uart_inst_t *const uart0;
+extern uart_inst_t *const uart1;
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx, bool tx);
+bool uart_is_writable(uart_inst_t *uart);
+bool uart_is_readable(uart_inst_t *uart);
+void uart_putc_raw(uart_inst_t *uart, char c);
+char uart_getc(uart_inst_t *uart);
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len);
@@ -0,0 +1,26 @@
+#pragma once
+
+// The subset of the pico-sdk that the host build of the firmware uses,
+// implemented on top of host_board.h.
+
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+enum gpio_function { GPIO_FUNC_UART = 2 };
+
+void gpio_set_function(uint gpio, gpio_function fn);
+
+absolute_time_t get_absolute_time();
+uint32_t to_ms_since_boot(absolute_time_t t);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+bool time_reached(absolute_time_t t);
+uint32_t time_us_32();
+uint64_t time_us_64();
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+// Busy waits advance the virtual time a little, see host_board.h.
+void tight_loop_contents();
@@ -0,0 +1,131 @@
+// Checks Random (random.h): its PCG32 output against the reference
+// generator, the bounds of below() and range() and that shuffle() permutes.
+// The bounds and shuffle checks run from RANDOM_SEED, which the host build
+// takes from BUSYBOARD_RANDOM_SEED like the firmware does.
+//
+// Exits non-zero if a check fails.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#include "random.h"
+
+#ifndef RANDOM_SEED
+#define RANDOM_SEED 1
+#endif
+
+namespace {
+
+int failures = 0;
+
+auto check(bool ok, const char *what) -> void {
+  if (!ok) {
+    std::printf("FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// pcg32_srandom_r() of the PCG reference with initstate = seed and the
+// default increment, followed by pcg32_random_r().
+struct Reference {
+  uint64_t seed;
+  uint32_t values[6];
+};
+constexpr Reference references[] = {
+    {0, {0xe823a24e, 0x7a7ecbd9, 0x89fd6c06, 0xae646aa8, 0xcd3cf945,
+         0x6204b303}},
+    {42, {0xc2f57bd6, 0x6b07c4a9, 0x72b7b29b, 0x44215383, 0xf5af5ead,
+          0x68beb632}},
+    {0x853c49e6748fea9bull,
+     {0xff597e28, 0x0d9a03a4, 0x37a69495, 0x62a4ee8c, 0xa8700e2a,
+      0x1b55fb62}},
+};
+
+auto check_reference() -> void {
+  for (auto const &ref : references) {
+    Random r(ref.seed);
+    for (uint32_t const value : ref.values)
+      check(r.next() == value, "next() matches the PCG32 reference");
+  }
+  Random r;
+  r.seed(42);
+  check(r.next() == references[1].values[0], "seed() restarts the sequence");
+}
+
+auto check_below() -> void {
+  Random r(RANDOM_SEED);
+  constexpr uint32_t bounds[] = {1, 2, 3, 6, 7, 1000, 0x80000001u, 0xffffffffu};
+  for (uint32_t const bound : bounds) {
+    bool ok = true;
+    for (int i = 0; i < 10000; ++i)
+      ok &= r.below(bound) < bound;
+    check(ok, "below(bound) < bound");
+  }
+
+  // A die: every face within 5% of its expected count.
+  constexpr int DRAWS = 60000;
+  int counts[6] = {};
+  for (int i = 0; i < DRAWS; ++i)
+    counts[r.below(6)]++;
+  auto const [lo, hi] =
+      std::minmax_element(std::begin(counts), std::end(counts));
+  check(*lo > DRAWS / 6 * 95 / 100 && *hi < DRAWS / 6 * 105 / 100,
+        "below(6) is uniform");
+}
+
+auto check_range() -> void {
+  Random r(RANDOM_SEED);
+  bool ok = true;
+  bool seen_lo = false;
+  bool seen_hi = false;
+  for (int i = 0; i < 10000; ++i) {
+    int32_t const v = r.range(-3, 4);
+    ok &= v >= -3 && v < 4;
+    seen_lo |= v == -3;
+    seen_hi |= v == 3;
+  }
+  check(ok, "range(lo, hi) stays in [lo, hi)");
+  check(seen_lo && seen_hi, "range(lo, hi) reaches both ends");
+}
+
+auto check_shuffle() -> void {
+  Random r(RANDOM_SEED);
+  for (size_t const n : {0, 1, 2, 8, 100}) {
+    std::vector<int> v(n);
+    std::iota(v.begin(), v.end(), 0);
+    r.shuffle(v.begin(), v.end());
+    std::vector<int> sorted = v;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<int> expected(n);
+    std::iota(expected.begin(), expected.end(), 0);
+    check(sorted == expected, "shuffle() returns a permutation");
+  }
+
+  // The same seed replays the same order.
+  int a[8];
+  int b[8];
+  std::iota(std::begin(a), std::end(a), 0);
+  std::iota(std::begin(b), std::end(b), 0);
+  Random ra(RANDOM_SEED);
+  Random rb(RANDOM_SEED);
+  ra.shuffle(std::begin(a), std::end(a));
+  rb.shuffle(std::begin(b), std::end(b));
+  check(std::equal(std::begin(a), std::end(a), std::begin(b)),
+        "shuffle() is reproducible from the seed");
+}
+
+} // namespace
+
+int main() {
+  // Formatted like the RANDOM seed line of the firmware log.
+  std::printf("seed %016" PRIx64 "\n", static_cast<uint64_t>(RANDOM_SEED));
+  check_reference();
+  check_below();
+  check_range();
+  check_shuffle();
+  std::printf("%s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
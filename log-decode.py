@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+
+# Decodes the binary log of the firmware (see binary_log.h). The format
+# strings are read from the .log_fmt section of the ELF that runs on the
+# board.
+#
+#   ./log-decode.py build/busyboard.elf /dev/ttyACM0
+#   ./log-decode.py build/busyboard.elf capture.bin
+#
+# Chunks of the other streams of serial_out.h (bounce capture) are skipped,
+# and so is text printed by libraries between chunks.
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"LOG1"
+HEADER = struct.Struct("<4sHH")
+SECTION = ".log_fmt"
+
+CONVERSION = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)([diuxXcf%])")
+
+
+def format_section(path):
+    """Returns the contents of the .log_fmt section of an ELF file."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise SystemExit(f"{path}: not an ELF file")
+    is64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        entry = struct.Struct(endian + "IIQQQQIIQQ")
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        entry = struct.Struct(endian + "IIIIIIIIII")
+    sections = [entry.unpack_from(elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    for s in sections:
+        start = names[4] + s[0]
+        name = elf[start : elf.index(b"\0", start)].decode()
+        if name == SECTION:
+            return elf[s[4] : s[4] + s[5]]
+    raise SystemExit(f"{path}: no {SECTION} section, is it built with LOG()?")
+
+
+class Decoder:
+    def __init__(self, formats):
+        self.formats = formats
+        self.cache = {}
+        self.time_high = 0
+        self.last_time = None
+
+    def format_string(self, offset):
+        if offset not in self.cache:
+            if offset >= len(self.formats):
+                return None
+            end = self.formats.index(b"\0", offset)
+            self.cache[offset] = self.formats[offset:end].decode(errors="replace")
+        return self.cache[offset]
+
+    def time(self, t):
+        """Unwraps the 32 bit usec timestamps."""
+        if self.last_time is not None and t < self.last_time:
+            self.time_high += 1 << 32
+        self.last_time = t
+        return (self.time_high + t) / 1e6
+
+    def message(self, offset, args):
+        fmt = self.format_string(offset)
+        if fmt is None:
+            return f"<unknown format 0x{offset:04x}> {args}"
+        args = iter(args)
+
+        def convert(m):
+            flags, conversion = m.groups()
+            if conversion == "%":
+                return "%"
+            value = next(args, 0)
+            if conversion in "di":
+                value = value - (1 << 32) if value & 0x80000000 else value
+            elif conversion == "f":
+                (value,) = struct.unpack("<f", struct.pack("<I", value))
+            elif conversion == "u":
+                conversion = "d"
+            return f"%{flags}{conversion}" % value
+
+        return CONVERSION.sub(convert, fmt)
+
+    def chunk(self, words, dropped, out):
+        if dropped:
+            out.write(f"<{dropped} records dropped>\n")
+        i = 0
+        while i + 2 <= len(words):
+            header, t = words[i], words[i + 1]
+            argc = (header >> 16) & 0xFF
+            args = words[i + 2 : i + 2 + argc]
+            i += 2 + argc
+            out.write(f"[{self.time(t):12.6f}] {self.message(header & 0xFFFF, args)}\n")
+        out.flush()
+
+
+def read_chunks(f, block_size=1 << 12):
+    """Yields (words, dropped) of the log chunks in a byte stream."""
+    buf = b""
+    while True:
+        block = f.read(block_size)
+        if not block:
+            return
+        buf += block
+        while True:
+            start = buf.find(MAGIC)
+            if start < 0:
+                buf = buf[-(len(MAGIC) - 1) :]
+                break
+            if len(buf) - start < HEADER.size:
+                buf = buf[start:]
+                break
+            _, count, dropped = HEADER.unpack_from(buf, start)
+            end = start + HEADER.size + 4 * count
+            if len(buf) < end:
+                buf = buf[start:]
+                break
+            words = struct.unpack_from(f"<{count}I", buf, start + HEADER.size)
+            yield words, dropped
+            buf = buf[end:]
+
+
+def open_input(path, baud):
+    if path.startswith("/dev/"):
+        import serial
+
+        port = serial.Serial(path, baud, timeout=0.2)
+
+        class Stream:
+            def read(self, n):
+                while True:
+                    data = port.read(n)
+                    if data:
+                        return data
+
+        return Stream()
+    return open(path, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("elf", help="the firmware running on the board")
+    parser.add_argument("input", help="serial port or a recorded byte stream")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    decoder = Decoder(format_section(args.elf))
+    for words, dropped in read_chunks(open_input(args.input, args.baud)):
+        decoder.chunk(words, dropped, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
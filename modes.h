@@ -2,4 +2,4 @@
 
 enum class FaderMode { RGB, HSV, Effect };
 
-enum class ArcadeMode { Binary, Names, SoundGame };
+enum class ArcadeMode { Binary, Names, SoundGame, Scope };
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+
+// Step timing for the gauge steppers (see vid2805.h).
+//
+// A move is planned one microstep at a time: the motor is at a "level" of
+// its ramp table and every microstep it goes one level up (accelerate),
+// stays (cruise) or goes one level down (decelerate). Going down takes as
+// many microsteps as the current level, so the planner starts to slow
+// down once the target is that close. As nothing else is precomputed, the
+// target and the speed limit can change at any time: the motor speeds up,
+// slows down or turns around from wherever it is, without stopping first.
+//
+// The tables hold the time between microsteps in usec for each level and
+// are computed at compile time:
+//  - Trapezoid: constant acceleration, v^2 = v0^2 + 2 a k.
+//  - SCurve: the speed follows a smoothstep over the ramp, so the
+//    acceleration starts and ends at zero (less jerk, quieter needles).
+#define MOTION_RAMP_LEVELS 256
+// Microsteps per second at level 0 and at the top of the tables.
+#define MOTION_START_SPEED 300
+#define MOTION_MAX_SPEED 1800
+
+namespace motion {
+
+enum class Profile : uint8_t { Trapezoid, SCurve };
+
+struct State {
+  int8_t direction = 0; // 0 when standing still
+  uint16_t level = 0;
+};
+
+namespace detail {
+
+constexpr auto sqrt(double x) -> double {
+  double r = x > 1 ? x : 1;
+  for (int i = 0; i < 64; ++i) {
+    r = 0.5 * (r + x / r);
+  }
+  return r;
+}
+
+constexpr auto interval_us(double microsteps_per_sec) -> uint16_t {
+  return static_cast<uint16_t>(1e6 / microsteps_per_sec + 0.5);
+}
+
+struct Table {
+  uint16_t us[MOTION_RAMP_LEVELS];
+};
+
+constexpr auto trapezoid_table() -> Table {
+  constexpr double v0 = MOTION_START_SPEED;
+  constexpr double v1 = MOTION_MAX_SPEED;
+  constexpr double two_a = (v1 * v1 - v0 * v0) / (MOTION_RAMP_LEVELS - 1);
+  Table t{};
+  for (int k = 0; k < MOTION_RAMP_LEVELS; ++k) {
+    t.us[k] = interval_us(sqrt(v0 * v0 + two_a * k));
+  }
+  return t;
+}
+
+constexpr auto s_curve_table() -> Table {
+  Table t{};
+  for (int k = 0; k < MOTION_RAMP_LEVELS; ++k) {
+    double const x = static_cast<double>(k) / (MOTION_RAMP_LEVELS - 1);
+    double const s = x * x * (3 - 2 * x);
+    t.us[k] = interval_us(MOTION_START_SPEED +
+                          (MOTION_MAX_SPEED - MOTION_START_SPEED) * s);
+  }
+  return t;
+}
+
+inline constexpr Table trapezoid = trapezoid_table();
+inline constexpr Table s_curve = s_curve_table();
+
+static_assert(trapezoid.us[0] == 3333 && s_curve.us[0] == 3333);
+static_assert(trapezoid.us[MOTION_RAMP_LEVELS - 1] == 556);
+
+} // namespace detail
+
+constexpr auto interval_us(Profile profile, uint16_t level) -> uint16_t {
+  return (profile == Profile::SCurve ? detail::s_curve : detail::trapezoid)
+      .us[level];
+}
+
+// The highest level that does not exceed `microsteps_per_sec`.
+constexpr auto max_level(Profile profile, uint32_t microsteps_per_sec)
+    -> uint16_t {
+  uint16_t level = 0;
+  while (level + 1 < MOTION_RAMP_LEVELS &&
+         uint64_t{interval_us(profile, level + 1)} * microsteps_per_sec >=
+             1000000) {
+    ++level;
+  }
+  return level;
+}
+
+// Plans the next microstep towards `distance` (target - position).
+// Returns the direction of the microstep, or 0 once the target is reached
+// and the motor stands still. The next call is due interval_us(level)
+// later.
+constexpr auto advance(int32_t distance, State &state, uint16_t max_level)
+    -> int8_t {
+  if (state.direction == 0) {
+    if (distance == 0)
+      return 0;
+    state.direction = distance > 0 ? 1 : -1;
+    state.level = 0;
+    return state.direction;
+  }
+
+  int32_t const remaining = distance * state.direction;
+  if (remaining <= state.level || state.level > max_level) {
+    if (state.level == 0) {
+      // Reached the target, or it moved behind us: stop, and turn around
+      // if need be.
+      state.direction = 0;
+      return advance(distance, state, max_level);
+    }
+    state.level--;
+  } else if (remaining > state.level + 1 && state.level < max_level) {
+    // Still able to stop in time from the next level up.
+    state.level++;
+  }
+  return state.direction;
+}
+
+} // namespace motion
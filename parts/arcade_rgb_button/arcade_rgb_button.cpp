@@ -8,8 +8,11 @@
 
 #include <PicoLed.hpp>
 
+#include "binary_log.h"
+#include "bounce_capture.h"
 #include "color.h"
 #include "debounce.h"
+#include "serial_out.h"
 
 // int main() {
 //   stdio_init_all();
@@ -40,24 +43,10 @@ Debounce_PCF8575 d16(i2c1, 0x20, 500);
 #define FPS 60
 #define MS_PER_FRAME 16
 
-#ifdef MEASURE_BOUNCE_TIMES
-uint32_t times[256][2];
-uint32_t time_idx = 0;
+#ifdef BOUNCE_CAPTURE
+// Run bounce-capture.py on the host to record and analyze the edges.
 void sample_callback(uint gpio, uint32_t events) {
-  if (time_idx >= 256) {
-    return;
-  }
-  if (gpio == BUTTON_PIN) {
-    if (events & GPIO_IRQ_EDGE_RISE) {
-      times[time_idx][0] = time_us_32();
-      times[time_idx][1] = 1;
-    }
-    if (events & GPIO_IRQ_EDGE_FALL) {
-      times[time_idx][0] = time_us_32();
-      times[time_idx][1] = 0;
-    }
-    ++time_idx;
-  }
+  bounce_capture.on_gpio_event(gpio, events);
 }
 #endif
 
@@ -131,6 +120,7 @@ int64_t on_frame(alarm_id_t id, void *user_data) {
 
 int main() {
   stdio_init_all();
+  serial_out.add(binary_log);
 
   i2c_init(i2c1, 100 * 1000);
   gpio_set_function(I2C_1_SDA_PIN, GPIO_FUNC_I2C);
@@ -149,21 +139,21 @@ int main() {
     led_hues[i] = i / static_cast<float>(LED_LENGTH) * 360.f;
   }
 
-#ifdef MEASURE_BOUNCE_TIMES
-  for (auto i = 0; i < 256; ++i) {
-    for (auto j = 0; j < 2; ++j) {
-      times[i][j] = 0;
-    }
-  }
-#endif
-
   gpio_init(BUTTON_PIN);
   gpio_set_dir(BUTTON_PIN, GPIO_IN);
   gpio_pull_up(BUTTON_PIN);
-#ifdef MEASURE_BOUNCE_TIMES
+#ifdef BOUNCE_CAPTURE
+  bounce_capture.select_gpio(BUTTON_PIN);
+  bounce_capture.select_pcf8575(0, 0xffff);
+  d16.set_capture_device(0);
+  serial_out.add(bounce_capture);
   gpio_set_irq_enabled_with_callback(BUTTON_PIN,
                                      GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
                                      true, &sample_callback);
+  while (true) {
+    d16.loop();
+    serial_out.drain();
+  }
 #else
   // gpio_set_irq_enabled_with_callback(BUTTON_PIN,
   //                                    GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
@@ -206,18 +196,6 @@ int main() {
 #endif
 
   while (true) {
-#if MEASURE_BOUNCE_TIMES
-    if (!printed && time_us_32() >= 10 * 1000 * 1000) {
-      for (auto i = 0; i <= time_idx; ++i) {
-        for (auto j = 0; j < 2; ++j) {
-          std::cout << times[i][j] << " ";
-        }
-        std::cout << std::endl;
-      }
-      printed = true;
-    }
-#endif
-
     // if (debounce.state() != last_state) {
     //    last_state = debounce.state();
     //    std::cout << "button state = " << last_state << std::endl;
@@ -237,6 +215,8 @@ int main() {
     // }
     //
 
+    serial_out.drain();
+
     if (d16.loop()) {
       std::cout << "pcf8575_changed!" << std::endl;
       std::cout << "IO expander says: " << std::bitset<16>(d16.state())
@@ -252,8 +232,8 @@ int main() {
       ledStrip.show();
     }
 #endif
+  }
 #endif
-}
 
-return 0;
+  return 0;
 }
@@ -1,7 +1,10 @@
+# Plots one edge list, e.g. from `bounce-capture.py analyze --csv`.
+import sys
+
 from matplotlib import pyplot as plot
 import numpy as np
 
-with open("bounce.csv") as f:
+with open(sys.argv[1] if len(sys.argv) > 1 else "bounce.csv") as f:
     x = [0]
     y = [1]
 
@@ -6,17 +6,10 @@ import sys
 from matplotlib import pyplot as plt
 from functools import partial
 
-def microstep_table_from_pdf_in_mV():
-    # See VID Micro Step Calculation Table PDF
-    PM = 15.30 # mA
-    P1 = 14.80 # mA
-    P2 = 13.25 # mA
-    P3 = 9.75  # mA
-    P4 = 5.59  # mA
-    P5 = 2.85  # mA
-
-    R_COIL = 280 # Ohm
+from vid28_model import PM, P1, P2, P3, P4, P5, R_COIL, WAVELENGTH
 
+def microstep_table_from_pdf_in_mV():
+    # See VID Micro Step Calculation Table PDF (vid28_model.py)
     signal1 = np.asarray([-P4, -P5, 0, P5, P4, P3, P2, P1, PM, P1, P2, P3])
     signal1 = np.hstack([signal1, -signal1]) # len = 24 one wavelength
     # adjust with respect to partial step diagram in the Stepper Motor 
@@ -57,7 +50,6 @@ def partial_step_signals_from_pdf_in_binary():
 
 #-------------------------------------------------------------------------------
 
-WAVELENGTH = 24
 N_PERIODS = 4
 MICROSTEPS_PER_PARTIAL_STEP = 4
 amplitude_voltage = 5 # [V]
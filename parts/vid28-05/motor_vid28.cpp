@@ -209,6 +209,9 @@ int main() {
 
   stepper.reset(1, speed);
   stepper.set_zero(-angle_dial_start);
+  while (stepper.moving()) {
+    tight_loop_contents();
+  }
 
   std::cout << "reset done" << std::endl;
   sleep_ms(1000);
@@ -217,6 +220,10 @@ int main() {
     int s = 64;
     for (int i = 0; i <= 256; i += s) {
       stepper.step_to(-i * angle_step, speed);
+      while (stepper.moving()) {
+        tight_loop_contents();
+      }
+      std::cout << "step_to went to angle = " << stepper.angle() << std::endl;
       sleep_ms(250);
     }
   }
@@ -0,0 +1,77 @@
+# Current model of the VID28-05 gauge stepper, shared by microstep.py (plots)
+# and generate-microstep-table.py (firmware tables). Plain Python, so that
+# it can run as part of the build.
+
+import math
+
+# See VID Micro Step Calculation Table PDF: coil current at the 24
+# microsteps of one electrical cycle, from the peak down to zero.
+PM = 15.30  # mA
+P1 = 14.80  # mA
+P2 = 13.25  # mA
+P3 = 9.75  # mA
+P4 = 5.59  # mA
+P5 = 2.85  # mA
+
+R_COIL = 280  # Ohm
+
+WAVELENGTH = 24
+
+# Coil 2 lags coil 1 by 60 degrees (4 microsteps), see the partial step
+# diagram in the Stepper Motor Specification datasheet.
+COIL_2_LAG = 4
+
+
+def datasheet_current(k):
+    """Coil current in mA at integer microstep k, peak at k = 0."""
+    quarter = [PM, P1, P2, P3, P4, P5, 0.0]
+    k %= WAVELENGTH
+    if k > WAVELENGTH // 2:
+        k = WAVELENGTH - k
+    if k > WAVELENGTH // 4:
+        return -quarter[WAVELENGTH // 2 - k]
+    return quarter[k]
+
+
+# The datasheet table is a flattened sine. Its 1st, 3rd and 5th harmonic
+# give a smooth curve through (close to) all 24 points.
+HARMONICS = [1, 3, 5]
+
+
+def _coefficients():
+    return [
+        2.0
+        / WAVELENGTH
+        * sum(
+            datasheet_current(k) * math.cos(2 * math.pi * h * k / WAVELENGTH)
+            for k in range(WAVELENGTH)
+        )
+        for h in HARMONICS
+    ]
+
+
+COEFFICIENTS = _coefficients()
+
+
+def current(x):
+    """Coil current in mA at a fractional microstep x."""
+    return sum(
+        a * math.cos(2 * math.pi * h * x / WAVELENGTH)
+        for h, a in zip(HARMONICS, COEFFICIENTS)
+    )
+
+
+def coil_voltages(x):
+    """(U1, U2) in V at microstep x, with the phase of the firmware tables:
+    pin 1 of the old 24 entry table peaked half a microstep earlier."""
+    return (
+        R_COIL * current(x + 0.5) / 1000.0,
+        R_COIL * current(x + 0.5 - COIL_2_LAG) / 1000.0,
+    )
+
+
+def pin_voltages(x):
+    """(pin 1, pin 2/3, pin 4) relative to the mid supply, such that
+    U1 = pin 1 - pin 2/3 and U2 = pin 4 - pin 2/3 and the three sum to 0."""
+    u1, u2 = coil_voltages(x)
+    return ((2 * u1 - u2) / 3, -(u1 + u2) / 3, (2 * u2 - u1) / 3)
@@ -2,8 +2,7 @@
 
 #include <pico/stdlib.h>
 
-#include <iostream>
-
+#include "binary_log.h"
 #include "color.h"
 
 #define FADE_IN_FRAMES = 60;
@@ -25,6 +24,7 @@ void Phone::reset() {
   frame_ = 0;
   dialed_number_ = -1;
   last_edge_time_ = -1;
+  last_pulse_us_ = 0;
   num_ = 0;
 }
 
@@ -33,11 +33,11 @@ void Phone::loop(bool dial_in_progress, bool num_switched) {
 
   if (dial_in_progress != last_dial_in_progress_) {
     if (dial_in_progress) {
-      std::cout << "DIALING STARTS" << std::endl;
+      LOG("DIALING STARTS");
       reset();
       new_state = State::Dialing;
     } else {
-      std::cout << "DIALING ENDS" << std::endl;
+      LOG("DIALING ENDS");
       new_state = State::NumberDisplay;
       frame_ = 0;
     }
@@ -48,8 +48,12 @@ void Phone::loop(bool dial_in_progress, bool num_switched) {
       if (last_edge_time_ < 0) {
         last_edge_time_ = to_ms_since_boot(get_absolute_time());
       } else if (to_ms_since_boot(get_absolute_time()) - last_edge_time_ >= 5) {
-        std::cout << "PHONE NUM " << num_ << std::endl;
+        LOG("PHONE NUM %d", num_);
         num_ += 1;
+        auto const now = time_us_64();
+        pulse_interval_us_ = last_pulse_us_ ? now - last_pulse_us_ : 0;
+        last_pulse_us_ = now;
+        pulse_edges_++;
       }
     }
   }
@@ -60,7 +64,7 @@ void Phone::loop(bool dial_in_progress, bool num_switched) {
       num_ = 0;
     }
     dialed_number_ = num_;
-    std::cout << "NEW DIALED NUM " << (int)dialed_number_ << std::endl;
+    LOG("NEW DIALED NUM %d", dialed_number_);
   }
 
   state_ = new_state;
@@ -18,6 +18,11 @@ public:
 
   int8_t dialed_number() { return dialed_number_; }
 
+  // Number of counted dial pulse edges since boot, and the time between
+  // the last two edges of the current dial (0 after the first one).
+  uint32_t pulse_edges() const { return pulse_edges_; }
+  uint32_t pulse_interval_us() const { return pulse_interval_us_; }
+
 private:
   void next_frame();
   void reset();
@@ -31,4 +36,7 @@ private:
   bool last_dial_in_progress_ = false;
 
   int64_t last_edge_time_ = -1;
+  uint64_t last_pulse_us_ = 0;
+  uint32_t pulse_edges_ = 0;
+  uint32_t pulse_interval_us_ = 0;
 };
@@ -0,0 +1,115 @@
+#include "pwm_audio.h"
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+
+namespace {
+PwmAudio *pwm_audio = nullptr;
+
+void pwm_audio_dma_irq() { pwm_audio->on_dma_complete(); }
+
+void pwm_audio_core1() { pwm_audio->run(); }
+} // namespace
+
+PwmAudio::PwmAudio(uint8_t pin) : pin_(pin) {}
+
+auto PwmAudio::init() -> void {
+  gpio_set_function(pin_, GPIO_FUNC_PWM);
+  slice_ = pwm_gpio_to_slice_num(pin_);
+  pwm_config config = pwm_get_default_config();
+  pwm_config_set_wrap(&config, PWM_AUDIO_WRAP);
+  pwm_init(slice_, &config, true);
+  pwm_set_gpio_level(pin_, (PWM_AUDIO_WRAP + 1) / 2);
+
+  for (int i = 0; i < 2; ++i) {
+    fill(i);
+  }
+
+  // The timer ticks at clk_sys * 1 / N, 22049.7 Hz at 125 MHz.
+  int const timer = dma_claim_unused_timer(true);
+  dma_timer_set_fraction(timer, 1,
+                         clock_get_hz(clk_sys) / PWM_AUDIO_SAMPLE_RATE);
+
+  dma_channel_[0] = dma_claim_unused_channel(true);
+  dma_channel_[1] = dma_claim_unused_channel(true);
+  for (int i = 0; i < 2; ++i) {
+    dma_channel_config c = dma_channel_get_default_config(dma_channel_[i]);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, dma_get_timer_dreq(timer));
+    channel_config_set_chain_to(&c, dma_channel_[1 - i]);
+    // Writes both halves of the compare register, channel A and B.
+    dma_channel_configure(dma_channel_[i], &c, &pwm_hw->slice[slice_].cc,
+                          buffer_[i], PWM_AUDIO_BUFFER_SAMPLES, false);
+    dma_channel_set_irq1_enabled(dma_channel_[i], true);
+  }
+
+  pwm_audio = this;
+  multicore_launch_core1(pwm_audio_core1);
+}
+
+auto PwmAudio::run() -> void {
+  // The handler runs on the core that enables the interrupt.
+  irq_set_exclusive_handler(DMA_IRQ_1, pwm_audio_dma_irq);
+  irq_set_enabled(DMA_IRQ_1, true);
+  dma_channel_start(dma_channel_[0]);
+  while (true) {
+    __wfi();
+  }
+}
+
+auto PwmAudio::play(AdpcmClip const &clip, uint16_t volume) -> bool {
+  return push({&clip, volume});
+}
+
+auto PwmAudio::stop() -> bool { return push({nullptr, 0}); }
+
+auto PwmAudio::push(Command const &command) -> bool {
+  uint8_t const head = commands_head_;
+  uint8_t const next = (head + 1) % PWM_AUDIO_COMMANDS;
+  if (next == commands_tail_)
+    return false;
+  commands_[head] = command;
+  // The command has to be visible to core 1 before the new head.
+  __dmb();
+  commands_head_ = next;
+  return true;
+}
+
+auto PwmAudio::on_dma_complete() -> void {
+  for (int i = 0; i < 2; ++i) {
+    if (dma_channel_get_irq1_status(dma_channel_[i])) {
+      dma_channel_acknowledge_irq1(dma_channel_[i]);
+      // The other channel is playing now; re-arm this one for when it is
+      // triggered by the chain and refill its buffer in the meantime.
+      dma_channel_set_read_addr(dma_channel_[i], buffer_[i], false);
+      fill(i);
+    }
+  }
+}
+
+auto PwmAudio::fill(int buffer) -> void {
+  while (commands_tail_ != commands_head_) {
+    __dmb();
+    Command const command = commands_[commands_tail_];
+    commands_tail_ = (commands_tail_ + 1) % PWM_AUDIO_COMMANDS;
+    if (command.clip) {
+      mixer_.play(*command.clip, command.volume);
+    } else {
+      mixer_.stop();
+    }
+  }
+
+  mixer_.mix(mix_, PWM_AUDIO_BUFFER_SAMPLES);
+  uint32_t *out = buffer_[buffer];
+  for (int i = 0; i < PWM_AUDIO_BUFFER_SAMPLES; ++i) {
+    uint32_t const level = (mix_[i] + 32768) * (PWM_AUDIO_WRAP + 1) >> 16;
+    out[i] = level | (level << 16);
+  }
+  buffers_ = buffers_ + 1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#include <cstdint>
+
+#include "adpcm.h"
+#include "audio_mixer.h"
+
+#define PWM_AUDIO_SAMPLE_RATE 22050
+// 128 samples are 5.8 ms: the time core 1 has to refill a buffer.
+#define PWM_AUDIO_BUFFER_SAMPLES 128
+// 10 bit output at a 122 kHz carrier (125 MHz system clock), far above
+// what the speaker and the RC filter in front of the amplifier pass.
+#define PWM_AUDIO_WRAP 1023
+#define PWM_AUDIO_COMMANDS 8
+
+// Plays short ADPCM clips (see generate-audio-clips.py) from flash through
+// a PWM pin, without the latency of the DFPlayer.
+//
+// Two DMA channels chained to each other feed the PWM compare register
+// from a pair of buffers, paced by a DMA timer at the sample rate. The
+// buffers are refilled by the mixer on core 1 from the DMA interrupt, so
+// core 0 only hands over play() requests through a small queue.
+class PwmAudio {
+public:
+  explicit PwmAudio(uint8_t pin);
+
+  // Claims the PWM slice, the DMA channels and timer and starts core 1.
+  auto init() -> void;
+
+  // Can be called from core 0 at any time. Returns false if the queue to
+  // core 1 is full. `volume` is 0..256.
+  auto play(AdpcmClip const &clip, uint16_t volume = 256) -> bool;
+  auto stop() -> bool;
+
+  // Number of buffers mixed so far.
+  auto buffers() const -> uint32_t { return buffers_; }
+
+  // Run on core 1.
+  auto run() -> void;
+  auto on_dma_complete() -> void;
+
+private:
+  struct Command {
+    AdpcmClip const *clip; // nullptr stops all voices
+    uint16_t volume;
+  };
+
+  auto push(Command const &command) -> bool;
+  auto fill(int buffer) -> void;
+
+  uint8_t pin_;
+  uint slice_ = 0;
+  int dma_channel_[2] = {-1, -1};
+
+  // Written by core 0 (head) and core 1 (tail) only.
+  Command commands_[PWM_AUDIO_COMMANDS];
+  volatile uint8_t commands_head_ = 0;
+  volatile uint8_t commands_tail_ = 0;
+
+  // Only touched on core 1.
+  AudioMixer mixer_;
+  int16_t mix_[PWM_AUDIO_BUFFER_SAMPLES];
+  uint32_t buffer_[2][PWM_AUDIO_BUFFER_SAMPLES];
+  volatile uint32_t buffers_ = 0;
+};
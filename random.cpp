@@ -0,0 +1,33 @@
+#include "random.h"
+
+#include "hardware/structs/rosc.h"
+#include "pico/stdlib.h"
+
+#include "binary_log.h"
+
+Random rng;
+
+namespace {
+// The ring oscillator's random bit is biased and correlated when read back
+// to back; the jitter between reads is what is collected here. Seeding
+// runs the bits through the generator, which spreads them out.
+auto rosc_seed() -> uint64_t {
+  uint64_t seed = 0;
+  for (int i = 0; i < 64; ++i) {
+    busy_wait_us_32(1);
+    seed = (seed << 1) | (rosc_hw->randombit & 1);
+  }
+  return seed ^ time_us_64();
+}
+} // namespace
+
+auto random_init() -> void {
+#ifdef RANDOM_SEED
+  uint64_t const seed = RANDOM_SEED;
+#else
+  uint64_t const seed = rosc_seed();
+#endif
+  rng.seed(seed);
+  LOG("RANDOM seed %08x%08x", static_cast<uint32_t>(seed >> 32),
+      static_cast<uint32_t>(seed));
+}
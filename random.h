@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+// PCG32 (XSH RR) pseudo random numbers for the game logic.
+//
+// The firmware seeds `rng` from the ring oscillator at boot, so every unit
+// plays differently. Configure with -DBUSYBOARD_RANDOM_SEED=<n> to start
+// from a fixed seed instead; the same seed and inputs replay the same run,
+// on the board or on the host. The seed is logged at boot either way.
+
+class Random {
+public:
+  constexpr explicit Random(uint64_t seed = 0) { this->seed(seed); }
+
+  constexpr auto seed(uint64_t seed) -> void {
+    state_ = 0;
+    next();
+    state_ += seed;
+    next();
+  }
+
+  constexpr auto next() -> uint32_t {
+    uint64_t const old = state_;
+    state_ = old * MULTIPLIER + INCREMENT;
+    auto const xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    auto const rot = static_cast<uint32_t>(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+  }
+
+  // Uniform in [0, bound), bound > 0. Multiply and shift (Lemire), which
+  // needs no division except to reject the rare biased values.
+  constexpr auto below(uint32_t bound) -> uint32_t {
+    uint64_t m = static_cast<uint64_t>(next()) * bound;
+    auto low = static_cast<uint32_t>(m);
+    if (low < bound) {
+      uint32_t const threshold = -bound % bound;
+      while (low < threshold) {
+        m = static_cast<uint64_t>(next()) * bound;
+        low = static_cast<uint32_t>(m);
+      }
+    }
+    return m >> 32;
+  }
+
+  // Uniform in [lo, hi), lo < hi.
+  constexpr auto range(int32_t lo, int32_t hi) -> int32_t {
+    return lo + static_cast<int32_t>(below(static_cast<uint32_t>(hi - lo)));
+  }
+
+  // Fisher-Yates.
+  template <typename It> constexpr auto shuffle(It first, It last) -> void {
+    auto const n = static_cast<uint32_t>(std::distance(first, last));
+    for (uint32_t i = n; i > 1; --i) {
+      using std::swap;
+      swap(first[i - 1], first[below(i)]);
+    }
+  }
+
+private:
+  static constexpr uint64_t MULTIPLIER = 6364136223846793005ull;
+  static constexpr uint64_t INCREMENT = 1442695040888963407ull;
+
+  uint64_t state_ = 0;
+};
+
+extern Random rng;
+
+// Seeds `rng`, from BUSYBOARD_RANDOM_SEED or the ring oscillator.
+auto random_init() -> void;
@@ -0,0 +1,41 @@
+#include "scope.h"
+
+#include <algorithm>
+
+auto Scope::configure(uint8_t channel, uint32_t full_scale, Style style)
+    -> void {
+  channels_[channel].full_scale = std::max(full_scale, 1u);
+  channels_[channel].style = style;
+}
+
+auto Scope::push(uint8_t channel, uint32_t value) -> void {
+  auto &c = channels_[channel];
+  value = std::min(value, c.full_scale);
+  c.samples[c.head] = static_cast<uint64_t>(value) * 255 / c.full_scale;
+  c.head = (c.head + 1) % SCOPE_SAMPLES;
+}
+
+auto Scope::render(uint8_t channel, DotMatrix &dot_matrix) const -> void {
+  auto const &c = channels_[channel];
+
+  // Bit r of a column is framebuffer row r, and row 0 is at the bottom of
+  // the (upside down mounted) display.
+  uint8_t columns[SCOPE_SAMPLES];
+  uint8_t prev = 0xff;
+  for (int x = 0; x < SCOPE_SAMPLES; ++x) {
+    uint8_t const sample = c.samples[(c.head + x) % SCOPE_SAMPLES];
+    if (c.style == Style::Bars) {
+      // Height 0..8
+      uint8_t const height = (sample * (DOT_MATRIX_ROWS + 1)) >> 8;
+      columns[x] = (1u << height) - 1;
+    } else {
+      // Row 0..7; connect to the previous sample so steps stay visible.
+      uint8_t const row = (sample * DOT_MATRIX_ROWS) >> 8;
+      uint8_t const from = prev == 0xff ? row : std::min(prev, row);
+      uint8_t const to = prev == 0xff ? row : std::max(prev, row);
+      columns[x] = ((2u << to) - 1) & ~((1u << from) - 1);
+      prev = row;
+    }
+  }
+  dot_matrix.blit_columns(columns);
+}
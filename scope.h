@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dotmatrix.h"
+
+#define SCOPE_CHANNELS 6
+// One sample per column.
+#define SCOPE_SAMPLES DOT_MATRIX_COLUMNS
+
+// Scrolling graphs of a few values on the dot matrix, e.g. faders or the
+// frame time.
+//
+// Each channel keeps the last SCOPE_SAMPLES samples in a ring buffer,
+// scaled to 0..255 when pushed. render() draws the selected channel with
+// the newest sample on the right, one column write per sample.
+class Scope {
+public:
+  enum class Style { Bars, Line };
+
+  Scope() = default;
+
+  // Values >= full_scale are drawn at the top.
+  auto configure(uint8_t channel, uint32_t full_scale, Style style) -> void;
+  auto push(uint8_t channel, uint32_t value) -> void;
+
+  auto render(uint8_t channel, DotMatrix &dot_matrix) const -> void;
+
+private:
+  struct Channel {
+    uint32_t full_scale = 255;
+    Style style = Style::Bars;
+    uint8_t samples[SCOPE_SAMPLES] = {};
+    uint8_t head = 0;
+  };
+
+  Channel channels_[SCOPE_CHANNELS];
+};
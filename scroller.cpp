@@ -0,0 +1,58 @@
+#include "scroller.h"
+
+#include <algorithm>
+
+#include "font.h"
+
+#define SCROLLER_CANVAS_MASK (SCROLLER_CANVAS_COLUMNS - 1)
+// Longer pauses between updates do not skip ahead further than this.
+#define SCROLLER_MAX_STEP_US 250000
+
+auto Scroller::start(const char *text, uint64_t now_us) -> void {
+  text_ = text;
+  next_char_ = text;
+  view_ = 0;
+  rendered_ = 0;
+  position_ = 0;
+  last_us_ = now_us;
+  while (rendered_ < DOT_MATRIX_COLUMNS) {
+    append_glyph();
+  }
+}
+
+auto Scroller::append_glyph() -> void {
+  if (*next_char_ == '\0')
+    next_char_ = text_;
+  // An empty text scrolls blank columns.
+  char const c = *next_char_ ? *next_char_++ : ' ';
+
+  auto const &glyph = font::glyph_columns(c);
+  for (int k = 0; k < 8; ++k) {
+    canvas_[(rendered_ + k) & SCROLLER_CANVAS_MASK] = glyph[k];
+  }
+  rendered_ += 8;
+}
+
+auto Scroller::update(uint64_t now_us) -> bool {
+  uint64_t const elapsed =
+      std::min(now_us - last_us_, static_cast<uint64_t>(SCROLLER_MAX_STEP_US));
+  last_us_ = now_us;
+  position_ += (elapsed * columns_per_second_ << 16) / 1000000;
+
+  uint32_t const view = position_ >> 16;
+  if (view == view_)
+    return false;
+  view_ = view;
+  while (rendered_ < view_ + DOT_MATRIX_COLUMNS) {
+    append_glyph();
+  }
+  return true;
+}
+
+auto Scroller::render(DotMatrix &dot_matrix) const -> void {
+  uint8_t columns[DOT_MATRIX_COLUMNS];
+  for (int k = 0; k < DOT_MATRIX_COLUMNS; ++k) {
+    columns[k] = canvas_[(view_ + k) & SCROLLER_CANVAS_MASK];
+  }
+  dot_matrix.blit_columns(columns);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dotmatrix.h"
+
+// Size of the ring buffered canvas in columns. Must be a power of two and
+// hold the visible columns plus one glyph.
+#define SCROLLER_CANVAS_COLUMNS 64
+static_assert((SCROLLER_CANVAS_COLUMNS & (SCROLLER_CANVAS_COLUMNS - 1)) == 0);
+static_assert(SCROLLER_CANVAS_COLUMNS >= DOT_MATRIX_COLUMNS + 8);
+
+// Scrolls a text of arbitrary length from right to left over the dot matrix.
+//
+// Glyph columns are rendered lazily into a small ring buffer just before
+// they become visible, so memory use does not depend on the length of the
+// text. The text repeats when it has scrolled through. The position is
+// derived from the elapsed time, so the speed does not depend on how often
+// update() is called.
+class Scroller {
+public:
+  Scroller() = default;
+
+  // `text` is not copied and must stay valid while scrolling.
+  auto start(const char *text, uint64_t now_us) -> void;
+  auto set_speed(uint16_t columns_per_second) -> void {
+    columns_per_second_ = columns_per_second;
+  }
+
+  // Advances the scroll position; returns true if the view moved.
+  auto update(uint64_t now_us) -> bool;
+  auto render(DotMatrix &dot_matrix) const -> void;
+
+private:
+  auto append_glyph() -> void;
+
+  const char *text_ = "";
+  const char *next_char_ = "";
+  uint16_t columns_per_second_ = 12;
+
+  uint8_t canvas_[SCROLLER_CANVAS_COLUMNS] = {};
+  // Absolute column numbers; the canvas index is the column modulo its size.
+  uint32_t view_ = 0;
+  uint32_t rendered_ = 0;
+
+  // Scroll position in 1/65536 columns.
+  uint64_t position_ = 0;
+  uint64_t last_us_ = 0;
+};
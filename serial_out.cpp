@@ -0,0 +1,49 @@
+#include "serial_out.h"
+
+SerialOut serial_out;
+
+namespace {
+constexpr uint32_t BYTES_PER_SEC = PICO_DEFAULT_UART_BAUD_RATE / 10;
+} // namespace
+
+auto SerialOut::add(ChunkStream &stream) -> void {
+  if (stream_count_ < SERIAL_OUT_MAX_STREAMS) {
+    streams_[stream_count_++] = &stream;
+  }
+}
+
+auto SerialOut::drain() -> void {
+  auto const now = time_us_32();
+  uint32_t const earned =
+      static_cast<uint64_t>(now - credit_us_) * BYTES_PER_SEC / 1000000;
+  if (credit_ + earned >= SERIAL_OUT_BURST_BYTES) {
+    credit_ = SERIAL_OUT_BURST_BYTES;
+    credit_us_ = now;
+  } else {
+    credit_ += earned;
+    // Round up, so that the credit never runs ahead of the UART.
+    credit_us_ += (earned * 1000000 + BYTES_PER_SEC - 1) / BYTES_PER_SEC;
+  }
+
+  while (credit_ > 0) {
+    if (!in_chunk_) {
+      // Take turns, starting with the stream after the last one.
+      uint8_t i = 0;
+      for (; i < stream_count_; ++i) {
+        current_ = (current_ + 1) % stream_count_;
+        if (streams_[current_]->start_chunk())
+          break;
+      }
+      if (i == stream_count_)
+        return;
+      in_chunk_ = true;
+    }
+    uint8_t byte;
+    if (!streams_[current_]->next_byte(byte)) {
+      in_chunk_ = false;
+      continue;
+    }
+    putchar_raw(byte);
+    credit_--;
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+// Shares stdout between the binary streams of the firmware (binary_log.h,
+// bounce_capture.h).
+//
+// Every stream sends chunks that start with their own magic, so the host
+// tools can pick theirs out of the mixed stream. The writer only switches
+// between streams at chunk boundaries, taking turns. It writes no more
+// bytes than the UART has moved since the last call (10 bits a byte at
+// PICO_DEFAULT_UART_BAUD_RATE), so the main loop never waits for it.
+//
+// Text written with printf() is not coordinated and may end up inside a
+// chunk; the decoders then lose that chunk.
+
+// Bytes written at most per drain() (the UART TX FIFO).
+#define SERIAL_OUT_BURST_BYTES 32
+#define SERIAL_OUT_MAX_STREAMS 2
+
+class ChunkStream {
+public:
+  // Prepares the next chunk, false if there is nothing to send.
+  virtual auto start_chunk() -> bool = 0;
+  // The next byte of the chunk, false once it is complete.
+  virtual auto next_byte(uint8_t &byte) -> bool = 0;
+
+protected:
+  ~ChunkStream() = default;
+};
+
+class SerialOut {
+public:
+  SerialOut() = default;
+
+  auto add(ChunkStream &stream) -> void;
+  auto drain() -> void;
+
+private:
+  ChunkStream *streams_[SERIAL_OUT_MAX_STREAMS] = {};
+  uint8_t stream_count_ = 0;
+  // The stream whose chunk is being written, or the last one that was.
+  uint8_t current_ = 0;
+  bool in_chunk_ = false;
+
+  // Bytes that can be written without waiting for the UART.
+  uint32_t credit_ = 0;
+  uint32_t credit_us_ = 0;
+};
+
+extern SerialOut serial_out;
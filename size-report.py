@@ -0,0 +1,392 @@
+#!/usr/bin/env python3
+
+"""Flash, RAM and stack report of the firmware images, run by the
+size_report target:
+
+  ninja -C build size_report
+  ./size-report.py --build-dir build busyboard=build/busyboard.elf
+
+Sizes come from the ELF, the linker map next to it (<elf>.map, written by
+pico_standard_link) and the -fstack-usage files of the target (see
+size_report_add() in CMakeLists.txt). Fails if an image exceeds one of
+its budgets in size-budgets.ini.
+"""
+
+import argparse
+import configparser
+import glob
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+from collections import defaultdict
+
+# RP2040 address map
+FLASH = (0x10000000, 0x10000000 + 16 * 1024 * 1024)
+RAM = (0x20000000, 0x20000000 + 264 * 1024)
+
+# Reserved by the pico linker script, not used by the code itself.
+RESERVED_SECTIONS = {".heap", ".stack_dummy", ".stack1_dummy"}
+
+SHF_WRITE = 1
+SHF_ALLOC = 2
+SHF_EXECINSTR = 4
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+PT_LOAD = 1
+
+TOP_UNITS = 15
+TOP_SYMBOLS = 20
+TOP_FRAMES = 10
+
+# Known heavy hitters, matched against the translation unit (archive
+# member) or the demangled symbol.
+CONTRIBUTORS = [
+    (
+        "iostream / locale",
+        re.compile(
+            r"libstdc\+\+[^(]*\((ios|locale|.*stream|.*facets|codecvt|ctype|"
+            r"c\+\+locale|messages|monetary|numeric|time_members|collate|"
+            r"compatibility|globals_io)"
+        ),
+        re.compile(r"^std::(basic_[io]?stream|basic_ios|ios_base|locale|"
+                   r"basic_streambuf|ctype|num_put|num_get|codecvt)"),
+    ),
+    (
+        "exceptions / unwinding",
+        re.compile(r"\((unwind|pr-support|libunwind|eh_\w+|.*unwind-arm)"),
+        re.compile(r"^(__cxa_|_Unwind_|__gxx_personality|__aeabi_unwind)"),
+    ),
+    (
+        "RTTI",
+        re.compile(r"\((tinfo|tinfo2|class_type_info|si_class_type_info|"
+                   r"vmi_class_type_info|dyncast)"),
+        re.compile(r"^typeinfo (name )?for "),
+    ),
+    (
+        "printf / scanf",
+        re.compile(r"libc[^(]*\((.*printf|.*scanf|.*dtoa|mprec|.*strtod)"),
+        re.compile(r"^(_?v?s?n?printf|_printf_\w+|__d?dtoa)"),
+    ),
+    (
+        "malloc",
+        re.compile(r"\((.*malloc\w*|.*freer|.*reallocr|.*callocr|mlock)"),
+        re.compile(r"^(_?malloc|_?free|_?realloc|_?calloc)(_r)?$"),
+    ),
+    (
+        "8x8 font",
+        None,
+        re.compile(r"^font(_data)?::"),
+    ),
+]
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1:
+            raise SystemExit(f"{path}: not a 32 bit ELF file")
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        phoff, = struct.unpack_from("<I", data, 0x1C)
+        phentsize, phnum, shentsize, shnum, shstrndx = struct.unpack_from(
+            "<HHHHH", data, 0x2A
+        )
+        self.segments = [
+            struct.unpack_from("<IIIIIIII", data, phoff + i * phentsize)
+            for i in range(phnum)
+        ]
+        raw = [
+            struct.unpack_from("<IIIIIIIIII", data, shoff + i * shentsize)
+            for i in range(shnum)
+        ]
+        names = raw[shstrndx]
+        self.sections = []
+        for name, type_, flags, addr, offset, size, link, _, _, _ in raw:
+            self.sections.append(
+                {
+                    "name": self.string(names[4], name),
+                    "type": type_,
+                    "flags": flags,
+                    "addr": addr,
+                    "lma": self.load_address(addr, type_, flags),
+                    "offset": offset,
+                    "size": size,
+                    "link": link,
+                }
+            )
+        self.by_name = {s["name"]: s for s in self.sections}
+
+    def string(self, table_offset, index):
+        start = table_offset + index
+        return self.data[start : self.data.index(b"\0", start)].decode()
+
+    def load_address(self, addr, type_, flags):
+        if not flags & SHF_ALLOC:
+            return None
+        for p_type, _, vaddr, paddr, filesz, memsz, _, _ in self.segments:
+            if p_type == PT_LOAD and vaddr <= addr < vaddr + max(memsz, 1):
+                return paddr + addr - vaddr
+        return addr
+
+    def symbols(self):
+        for s in self.sections:
+            if s["type"] != SHT_SYMTAB:
+                continue
+            strtab = self.sections[s["link"]]["offset"]
+            for i in range(s["size"] // 16):
+                name, value, size, info, _, shndx = struct.unpack_from(
+                    "<IIIBBH", self.data, s["offset"] + 16 * i
+                )
+                if size and (info & 0xF) in (1, 2) and 0 < shndx < len(self.sections):
+                    yield self.string(strtab, name), value & ~1, size, shndx
+
+
+def in_range(addr, region):
+    return addr is not None and region[0] <= addr < region[1]
+
+
+def classify(section):
+    """Returns (kind, flash, ram) of an output section."""
+    flags = section["flags"]
+    if not flags & SHF_ALLOC or section["name"] in RESERVED_SECTIONS:
+        return None, False, False
+    nobits = section["type"] == SHT_NOBITS
+    flash = not nobits and in_range(section["lma"], FLASH)
+    ram = in_range(section["addr"], RAM)
+    if nobits:
+        kind = "bss"
+    elif flags & SHF_EXECINSTR:
+        kind = "text"
+    elif flags & SHF_WRITE or ram:
+        kind = "data"
+    else:
+        kind = "rodata"
+    return kind, flash, ram
+
+
+def unit_name(path):
+    path = path.strip()
+    m = re.match(r"(.*\.a)\((.*)\)$", path)
+    if m:
+        return f"{os.path.basename(m.group(1))}({m.group(2)})"
+    if ".dir/" in path:
+        path = path.split(".dir/", 1)[1]
+    path = re.sub(r"\.(obj|o)$", "", path)
+    return re.sub(r"^(\.\./)+", "", path.replace("__/", "../"))
+
+
+def parse_map(path, elf):
+    """Yields (output section, input section, size, unit) from a GNU ld map."""
+    with open(path) as f:
+        lines = f.read().splitlines()
+    try:
+        start = lines.index("Linker script and memory map")
+    except ValueError:
+        raise SystemExit(f"{path}: not a GNU ld map file")
+
+    output = None
+    pending = None
+    for line in lines[start + 1 :]:
+        m = re.match(r"^(\.\S+)(?:\s+0x[0-9a-f]+\s+0x[0-9a-f]+)?", line)
+        if m and not line.startswith(" "):
+            output = m.group(1) if m.group(1) in elf.by_name else None
+            pending = None
+            continue
+        if output is None:
+            continue
+        m = re.match(r"^ (\*fill\*|[.\w]\S*)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(.*)$", line)
+        if m:
+            name, size, unit = m.group(1), int(m.group(3), 16), m.group(4)
+        elif pending:
+            m = re.match(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$", line)
+            name, pending = pending, None
+            if not m:
+                continue
+            size, unit = int(m.group(2), 16), m.group(3)
+        else:
+            m = re.match(r"^ ([.\w]\S*)$", line)
+            pending = m.group(1) if m else None
+            continue
+        if size == 0:
+            continue
+        unit = "(fill)" if name == "*fill*" else unit_name(unit) or "(linker)"
+        yield output, name, size, unit
+
+
+def stack_frames(build_dir, target):
+    """Yields (unit, function, bytes, qualifier) of the target's .su files."""
+    pattern = os.path.join(build_dir, "**", "CMakeFiles", f"{target}.dir", "**", "*.su")
+    for path in glob.glob(pattern, recursive=True):
+        unit = unit_name(path[: -len(".su")])
+        with open(path) as f:
+            for line in f:
+                parts = line.rstrip("\n").split("\t")
+                if len(parts) != 3:
+                    continue
+                # file:line:column:function, the function may contain ":"
+                function = parts[0].split(":", 3)[-1]
+                yield unit, function, int(parts[1]), parts[2]
+
+
+def demangle(names):
+    tool = shutil.which("arm-none-eabi-c++filt") or shutil.which("c++filt")
+    if not tool or not names:
+        return {n: n for n in names}
+    out = subprocess.run(
+        [tool], input="\n".join(names), capture_output=True, text=True
+    ).stdout.splitlines()
+    return dict(zip(names, out)) if len(out) == len(names) else {n: n for n in names}
+
+
+def kib(n):
+    return f"{n / 1024:8.1f} KiB"
+
+
+def report(target, elf_path, build_dir, budgets):
+    elf = Elf(elf_path)
+    kinds = {s["name"]: classify(s) for s in elf.sections}
+
+    totals = defaultdict(int)
+    for s in elf.sections:
+        kind, flash, ram = kinds[s["name"]]
+        if flash:
+            totals["flash"] += s["size"]
+        if ram:
+            totals["ram"] += s["size"]
+        if kind in ("data", "bss") and ram:
+            totals[kind] += s["size"]
+    reserved = sum(elf.by_name[n]["size"] for n in RESERVED_SECTIONS if n in elf.by_name)
+    init_array = elf.by_name.get(".init_array", {"size": 0})["size"]
+    exception_tables = sum(
+        s["size"] for s in elf.sections if s["name"].startswith((".ARM.extab", ".ARM.exidx"))
+    )
+
+    units = defaultdict(lambda: defaultdict(int))
+    constructors = defaultdict(int)
+    map_path = elf_path + ".map"
+    if os.path.exists(map_path):
+        for output, name, size, unit in parse_map(map_path, elf):
+            kind, flash, ram = kinds[output]
+            if flash:
+                units[unit]["flash"] += size
+            if ram:
+                units[unit]["ram"] += size
+            if kind:
+                units[unit][kind] += size
+            if output == ".init_array" or name.startswith(".init_array"):
+                constructors[unit] += size // 4
+    else:
+        print(f"warning: {map_path} is missing, no per unit sizes", file=sys.stderr)
+
+    symbols = list(elf.symbols())
+    names = demangle(sorted({name for name, _, _, _ in symbols}))
+
+    frames = sorted(stack_frames(build_dir, target), key=lambda f: -f[2])
+    frame_names = demangle(sorted({f[1] for f in frames}))
+
+    print(f"== {target} ({os.path.relpath(elf_path)})")
+    print(f"flash {kib(totals['flash'])}    ram {kib(totals['ram'])} "
+          f"(data {totals['data']}, bss {totals['bss']}, heap/stack reserved {reserved})")
+    print(f"static constructors {init_array // 4}, exception tables {exception_tables} bytes")
+    if frames:
+        unit, function, size, qualifier = frames[0]
+        print(f"largest stack frame {size} bytes ({qualifier}) in "
+              f"{frame_names[function]} ({unit})")
+
+    print()
+    print(f"{'translation unit':50s} {'flash':>8s} {'ram':>8s} {'text':>8s} "
+          f"{'rodata':>8s} {'data':>8s} {'bss':>8s} {'ctors':>5s} {'stack':>6s}")
+    max_frame = defaultdict(int)
+    for unit, _, size, _ in frames:
+        max_frame[unit] = max(max_frame[unit], size)
+    ranked = sorted(units.items(), key=lambda u: -(u[1]["flash"] + u[1]["ram"]))
+    for unit, s in ranked[:TOP_UNITS]:
+        print(f"{unit[-50:]:50s} {s['flash']:8d} {s['ram']:8d} {s['text']:8d} "
+              f"{s['rodata']:8d} {s['data']:8d} {s['bss']:8d} "
+              f"{constructors[unit]:5d} {max_frame.get(unit, 0):6d}")
+
+    print()
+    print(f"{'symbol':60s} {'bytes':>8s}  section")
+    for name, _, size, shndx in sorted(symbols, key=lambda s: -s[2])[:TOP_SYMBOLS]:
+        print(f"{names[name][:60]:60s} {size:8d}  {elf.sections[shndx]['name']}")
+
+    if frames:
+        print()
+        print(f"{'stack frame':60s} {'bytes':>8s}  unit")
+        for unit, function, size, qualifier in frames[:TOP_FRAMES]:
+            print(f"{frame_names[function][:60]:60s} {size:8d}  {unit} ({qualifier})")
+
+    print()
+    print("flagged contributors:")
+    flagged = False
+    for label, unit_re, symbol_re in CONTRIBUTORS:
+        size = 0
+        if unit_re:
+            size += sum(s["flash"] for u, s in units.items() if unit_re.search(u))
+        else:
+            size += sum(
+                sz for n, _, sz, shndx in symbols
+                if symbol_re.search(names[n]) and kinds[elf.sections[shndx]["name"]][1]
+            )
+        if label == "exceptions / unwinding":
+            size += exception_tables
+        if size:
+            flagged = True
+            print(f"  {label:24s} {kib(size)}")
+    if not flagged:
+        print("  none")
+
+    measured = {
+        "flash": totals["flash"],
+        "ram": totals["ram"],
+        "stack_frame": frames[0][2] if frames else 0,
+        "constructors": init_array // 4,
+    }
+    failures = []
+    for key, value in measured.items():
+        if key in budgets and value > budgets[key]:
+            failures.append(f"{target}: {key} {value} exceeds the budget of {budgets[key]}")
+    print()
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("images", nargs="+", metavar="target=elf")
+    parser.add_argument("--build-dir", required=True)
+    parser.add_argument("--budgets", help="size-budgets.ini")
+    parser.add_argument(
+        "--section",
+        action="append",
+        default=[],
+        metavar="target=section",
+        help="budgets of target, if not in the section named after it",
+    )
+    args = parser.parse_args()
+
+    budgets = configparser.ConfigParser()
+    if args.budgets:
+        budgets.read(args.budgets)
+
+    sections = dict(s.split("=", 1) for s in args.section)
+    failures = []
+    for image in args.images:
+        target, elf_path = image.split("=", 1)
+        name = sections.get(target, target)
+        section = budgets[name] if budgets.has_section(name) else budgets.defaults()
+        limits = {key: int(value, 0) for key, value in section.items()}
+        failures += report(target, elf_path, args.build_dir, limits)
+
+    for f in failures:
+        print(f"error: {f}", file=sys.stderr)
+    if failures:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,78 @@
+#include "sound_arbiter.h"
+
+namespace {
+struct SourcePolicy {
+  uint8_t priority;
+  uint16_t min_play_ms;
+};
+
+// Indexed by SoundSource.
+constexpr SourcePolicy policies[] = {
+    {3, 600}, // Dial: the dialed number should be heard completely
+    {2, 300}, // Arcade1
+    {1, 300}, // Names
+    {1, 150}, // SoundGame: fast button presses should be heard
+};
+static_assert(sizeof(policies) / sizeof(policies[0]) ==
+              static_cast<size_t>(SoundSource::Count));
+
+auto policy(SoundSource source) -> SourcePolicy const & {
+  return policies[static_cast<uint8_t>(source)];
+}
+
+auto same_sound(Sound const &a, Sound const &b) -> bool {
+  return a.folder == b.folder && a.track == b.track;
+}
+} // namespace
+
+auto SoundArbiter::request(SoundSource source, uint8_t folder, uint8_t track,
+                           uint16_t duration_ms, uint32_t now_ms) -> void {
+  Sound const sound = {source, folder, track, duration_ms};
+  if (pending_) {
+    if (policy(source).priority < policy(pending_->source).priority)
+      return;
+    stats_.replaced++;
+  }
+  pending_ = sound;
+  pending_since_ms_ = now_ms;
+}
+
+auto SoundArbiter::update(uint32_t now_ms, bool playing)
+    -> std::optional<Sound> {
+  if (!pending_)
+    return std::nullopt;
+
+  if (now_ms - pending_since_ms_ > SOUND_ARBITER_MAX_WAIT_MS) {
+    stats_.expired++;
+    pending_.reset();
+    return std::nullopt;
+  }
+
+  uint32_t const played_ms = now_ms - current_since_ms_;
+  if (current_ && current_->duration_ms) {
+    playing = played_ms < current_->duration_ms;
+  }
+  if (playing && current_) {
+    if (same_sound(*pending_, *current_) &&
+        played_ms < SOUND_ARBITER_DEDUP_MS) {
+      stats_.deduplicated++;
+      pending_.reset();
+      return std::nullopt;
+    }
+
+    auto const &next = policy(pending_->source);
+    auto const &cur = policy(current_->source);
+    bool const preempt =
+        next.priority > cur.priority ||
+        (next.priority == cur.priority && played_ms >= cur.min_play_ms);
+    if (!preempt)
+      return std::nullopt;
+    stats_.preempted++;
+  }
+
+  current_ = pending_;
+  current_since_ms_ = now_ms;
+  pending_.reset();
+  stats_.played++;
+  return current_;
+}
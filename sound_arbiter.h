@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+// Everything on the board that plays sounds.
+enum class SoundSource : uint8_t { Dial, Arcade1, Names, SoundGame, Count };
+
+struct Sound {
+  SoundSource source;
+  uint8_t folder;
+  uint8_t track;
+  // 0 if unknown.
+  uint16_t duration_ms;
+};
+
+// Decides which of the requested sounds actually gets played.
+//
+// Requests are collected during a frame and update() releases at most one
+// of them per frame:
+//  - a request of higher priority than the playing sound preempts it,
+//  - one of the same priority only after the playing sound had its
+//    minimum play time,
+//  - one of lower priority waits until the playing sound has finished.
+// Of several waiting requests, the one with the highest priority (the
+// latest on a tie) is kept. A request that waited longer than
+// SOUND_ARBITER_MAX_WAIT_MS is dropped, and the sound that is already
+// playing is not restarted within SOUND_ARBITER_DEDUP_MS.
+//
+// A sound with a known duration (from the sound manifest) counts as
+// playing for that long; otherwise the player's state is used.
+#define SOUND_ARBITER_MAX_WAIT_MS 500
+#define SOUND_ARBITER_DEDUP_MS 250
+
+class SoundArbiter {
+public:
+  struct Stats {
+    uint32_t played = 0;
+    uint32_t preempted = 0;
+    uint32_t replaced = 0;
+    uint32_t expired = 0;
+    uint32_t deduplicated = 0;
+  };
+
+  SoundArbiter() = default;
+
+  auto request(SoundSource source, uint8_t folder, uint8_t track,
+               uint16_t duration_ms, uint32_t now_ms) -> void;
+  // `playing`: whether the player is still busy with the last sound.
+  auto update(uint32_t now_ms, bool playing) -> std::optional<Sound>;
+
+  auto stats() const -> Stats const & { return stats_; }
+
+private:
+  std::optional<Sound> pending_;
+  uint32_t pending_since_ms_ = 0;
+
+  std::optional<Sound> current_;
+  uint32_t current_since_ms_ = 0;
+
+  Stats stats_;
+};
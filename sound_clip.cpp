@@ -0,0 +1,37 @@
+#include "sound_clip.h"
+
+#include "sound_manifest.h"
+
+namespace sound_clips {
+
+auto find(uint8_t folder, uint8_t track) -> SoundClip const * {
+  uint16_t const id = (folder << 8) | track;
+  uint16_t lo = 0;
+  uint16_t hi = sound_manifest::clip_count;
+  while (lo < hi) {
+    uint16_t const mid = (lo + hi) / 2;
+    auto const &clip = sound_manifest::clips[sound_manifest::by_id[mid]];
+    uint16_t const mid_id = (clip.folder << 8) | clip.track;
+    if (mid_id == id)
+      return &clip;
+    if (mid_id < id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return nullptr;
+}
+
+auto count(SoundCategory category) -> uint16_t {
+  auto const &range =
+      sound_manifest::categories[static_cast<uint8_t>(category)];
+  return range.end - range.first;
+}
+
+auto in_category(SoundCategory category, uint16_t i) -> SoundClip const & {
+  auto const &range =
+      sound_manifest::categories[static_cast<uint8_t>(category)];
+  return sound_manifest::clips[range.first + i];
+}
+
+} // namespace sound_clips
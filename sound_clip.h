@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Defined in the generated sound_manifest.h.
+enum class SoundCategory : uint8_t;
+
+// A sound file on the DFPlayer's SD card, see generate-sound-manifest.py.
+struct SoundClip {
+  uint8_t folder;
+  uint8_t track;
+  SoundCategory category;
+  uint16_t duration_ms;
+  uint32_t size;
+};
+
+struct SoundCategoryRange {
+  uint16_t first;
+  uint16_t end;
+};
+
+namespace sound_clips {
+
+// nullptr if the file is not in the manifest.
+auto find(uint8_t folder, uint8_t track) -> SoundClip const *;
+
+auto count(SoundCategory category) -> uint16_t;
+// i in [0, count(category))
+auto in_category(SoundCategory category, uint16_t i) -> SoundClip const &;
+
+} // namespace sound_clips
@@ -2,6 +2,8 @@
 
 #include "color.h"
 #include "gamma8.h"
+#include "random.h"
+#include "sprites.h"
 
 #include <algorithm>
 #include <numeric>
@@ -14,6 +16,9 @@
 #define COLOR_CHANGE_OUT 20
 #define COLOR_CHANGE_CHANGE 10
 #define PRESSED_HIGHLIGHT_TIME 60
+#define BALL_GRAVITY 8
+// Launch speed to reach the top row: sqrt(2 * gravity * drop height)
+#define BALL_BOUNCE_SPEED 156
 
 SoundGame::SoundGame() {
   for (int i = 0; i < 8; ++i) {
@@ -47,7 +52,7 @@ void SoundGame::next_frame(uint32_t frame) {
     state_frame_start_ = frame;
   } else if (state_ == State::FadeOut && frames_in_state >= FADE_OUT_FRAMES) {
     // state_ = State::ColorChange;
-    // std::random_shuffle(permutation_.begin(), permutation_.end());
+    // rng.shuffle(permutation_.begin(), permutation_.end());
     if (enabled_) {
       state_ = State::FadeIn;
       state_frame_start_ = frame;
@@ -97,7 +102,7 @@ void SoundGame::calc_frame(uint32_t frame, PicoLed::Color *strip_begin,
       }
 
       if (((frames_in_state - COLOR_CHANGE_IN) % COLOR_CHANGE_CHANGE) == 0) {
-        std::random_shuffle(permutation_.begin(), permutation_.end());
+        rng.shuffle(permutation_.begin(), permutation_.end());
       }
     }
 
@@ -113,44 +118,71 @@ void SoundGame::calc_frame(uint32_t frame, PicoLed::Color *strip_begin,
   next_frame(frame);
 }
 
+namespace {
+struct ButtonSounds {
+  SoundCategory category;
+  // Played if the manifest has no sounds of the category.
+  ArcadeSounds fallback;
+};
+
+constexpr ButtonSounds button_sounds[8] = {
+    {SoundCategory::alarms_rings_and_sirens,
+     ArcadeSounds::alarms_rings_and_sirens__ring_ring_1},
+    {SoundCategory::blips_and_beeps, ArcadeSounds::blips_and_beeps__bing_1},
+    {SoundCategory::movement_jump_and_drop,
+     ArcadeSounds::movement_jump_and_drop__jump_1},
+    {SoundCategory::noise_and_engine, ArcadeSounds::noise_and_engine__zapping},
+    {SoundCategory::score_sounds, ArcadeSounds::score_sounds__coins_1},
+    {SoundCategory::shots_and_explosions,
+     ArcadeSounds::shots_and_explosions__laser_shot_1},
+    {SoundCategory::sweeps, ArcadeSounds::sweeps__up_1},
+    {SoundCategory::transformation,
+     ArcadeSounds::transformation__beam_me_up_1},
+};
+} // namespace
+
+SoundCategory SoundGame::category_for_button(uint8_t button) {
+  return button_sounds[permutation(button)].category;
+}
+
 ArcadeSounds SoundGame::sound_for_button(uint8_t button) {
-  uint8_t sound_num = permutation(button);
+  auto const &sounds = button_sounds[permutation(button)];
+  uint16_t const count = sound_clips::count(sounds.category);
+  if (count == 0)
+    return sounds.fallback;
+
+  // ArcadeSounds values are folder << 8 | track.
+  auto const &clip =
+      sound_clips::in_category(sounds.category, rng.below(count));
+  return static_cast<ArcadeSounds>((clip.folder << 8) | clip.track);
+}
 
-  ArcadeSounds sound;
-  switch (sound_num) {
-  case 0: {
-    sound = ArcadeSounds::transformation__beam_me_up_1;
-    break;
-  }
-  case 1: {
-    sound = ArcadeSounds::transformation__swirl_1;
-    break;
-  }
-  case 2: {
-    sound = ArcadeSounds::blips_and_beeps__bing_1;
-    break;
-  }
-  case 3: {
-    sound = ArcadeSounds::sweeps__down_1;
-    break;
-  }
-  case 4: {
-    sound = ArcadeSounds::sweeps__up_1;
-    break;
-  }
-  case 5: {
-    sound = ArcadeSounds::score_sounds__coins_1;
-    break;
-  }
-  case 6: {
-    sound = ArcadeSounds::score_sounds__score_4;
-    break;
+void SoundGame::draw_frame(DotMatrix &dot_matrix) {
+  dot_matrix.clear();
+  if (state_ == State::Off)
+    return;
+
+  if (pressed_button_ >= 0) {
+    auto const &icon =
+        sprites::category_icon(category_for_button(pressed_button_));
+    dot_matrix.blit(icon, (DOT_MATRIX_COLUMNS - 8) / 2, 0);
+    return;
   }
-  case 7: {
-    sound = ArcadeSounds::noise_and_engine__zapping;
-    break;
+
+  int16_t const max_x = (DOT_MATRIX_COLUMNS - sprites::ball.width) << 8;
+  int16_t const max_y = (DOT_MATRIX_ROWS - sprites::ball.height) << 8;
+
+  ball_x_ += ball_dx_;
+  if (ball_x_ < 0 || ball_x_ > max_x) {
+    ball_dx_ = -ball_dx_;
+    ball_x_ = std::clamp(ball_x_, static_cast<int16_t>(0), max_x);
   }
+  ball_dy_ += BALL_GRAVITY;
+  ball_y_ += ball_dy_;
+  if (ball_y_ >= max_y) {
+    ball_y_ = max_y;
+    ball_dy_ = -BALL_BOUNCE_SPEED;
   }
 
-  return sound;
+  dot_matrix.blit(sprites::ball, ball_x_ >> 8, ball_y_ >> 8);
 }
@@ -4,6 +4,8 @@
 #include <array>
 
 #include "arcade_sounds.h"
+#include "dotmatrix.h"
+#include "sound_manifest.h"
 
 class SoundGame {
 public:
@@ -21,8 +23,15 @@ public:
 
   bool should_play_sound();
 
+  // Each button plays the sounds of one category.
+  SoundCategory category_for_button(uint8_t button);
+  // A random sound of the button's category.
   ArcadeSounds sound_for_button(uint8_t button);
 
+  // Draws the next animation frame: the category icon of the last pressed
+  // button's sound, or a bouncing ball.
+  void draw_frame(DotMatrix &dot_matrix);
+
 private:
   void next_frame(uint32_t frame);
 
@@ -33,4 +42,10 @@ private:
   std::array<uint8_t, 8> permutation_ = {0, 1, 2, 3, 4, 5, 6, 7};
   int8_t pressed_button_ = -1;
   uint32_t pressed_button_frame_ = 0;
+
+  // Ball position and velocity in 1/256 pixels (per frame).
+  int16_t ball_x_ = 0;
+  int16_t ball_y_ = 0;
+  int16_t ball_dx_ = 64;
+  int16_t ball_dy_ = 0;
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+// Generated by generate-sound-manifest.py from sounds/, do not edit.
+
+#include "sound_clip.h"
+
+enum class SoundCategory : uint8_t {
+  phone,
+  names,
+  alarms_rings_and_sirens,
+  blips_and_beeps,
+  movement_jump_and_drop,
+  noise_and_engine,
+  score_sounds,
+  shots_and_explosions,
+  sweeps,
+  transformation,
+  Count
+};
+
+namespace sound_manifest {
+
+// Grouped by category.
+inline constexpr SoundClip clips[] = {
+    {1, 0, SoundCategory::phone, 1161, 102444}, // sounds/01/000_de_0.wav
+    {1, 1, SoundCategory::phone, 1390, 122642}, // sounds/01/001_de_1.wav
+    {1, 2, SoundCategory::phone, 1630, 143810}, // sounds/01/002_de_2.wav
+    {1, 3, SoundCategory::phone, 1570, 138518}, // sounds/01/003_de_3.wav
+    {1, 4, SoundCategory::phone, 1620, 142928}, // sounds/01/004_de_4.wav
+    {1, 5, SoundCategory::phone, 1740, 153512}, // sounds/01/005_de_5.wav
+    {1, 6, SoundCategory::phone, 1640, 144692}, // sounds/01/006_de_6.wav
+    {1, 7, SoundCategory::phone, 1620, 142928}, // sounds/01/007_de_7.wav
+    {1, 8, SoundCategory::phone, 1410, 124406}, // sounds/01/008_de_8.wav
+    {1, 9, SoundCategory::phone, 1590, 140282}, // sounds/01/009_de_9.wav
+    {1, 10, SoundCategory::phone, 9120, 291840}, // sounds/01/010_vintage_phone_ringing.mp3
+    {2, 1, SoundCategory::names, 936, 9108}, // sounds/02/001_j.mp3
+    {2, 2, SoundCategory::names, 1080, 10440}, // sounds/02/002_j.mp3
+    {2, 3, SoundCategory::names, 936, 10512}, // sounds/02/003_j.mp3
+    {2, 4, SoundCategory::names, 936, 9108}, // sounds/02/004_j.mp3
+    {2, 5, SoundCategory::names, 864, 8712}, // sounds/02/005_j.mp3
+    {3, 1, SoundCategory::names, 684, 7596}, // sounds/03/001_t.mp3
+    {3, 2, SoundCategory::names, 648, 6768}, // sounds/03/002_t.mp3
+    {3, 3, SoundCategory::names, 792, 8424}, // sounds/03/003_t.mp3
+    {3, 4, SoundCategory::names, 792, 8280}, // sounds/03/004_t.mp3
+    {3, 5, SoundCategory::names, 576, 5832}, // sounds/03/005_t.mp3
+    {4, 1, SoundCategory::names, 792, 7812}, // sounds/04/001_c.mp3
+    {4, 2, SoundCategory::names, 900, 9072}, // sounds/04/002_c.mp3
+    {4, 3, SoundCategory::names, 936, 10548}, // sounds/04/003_c.mp3
+    {4, 4, SoundCategory::names, 936, 9828}, // sounds/04/004_c.mp3
+    {4, 5, SoundCategory::names, 864, 8928}, // sounds/04/005_c.mp3
+};
+inline constexpr uint16_t clip_count = 26;
+
+// [first, end) in clips per category.
+inline constexpr SoundCategoryRange categories[] = {
+    {0, 11}, // phone
+    {11, 26}, // names
+    {0, 0}, // alarms_rings_and_sirens
+    {0, 0}, // blips_and_beeps
+    {0, 0}, // movement_jump_and_drop
+    {0, 0}, // noise_and_engine
+    {0, 0}, // score_sounds
+    {0, 0}, // shots_and_explosions
+    {0, 0}, // sweeps
+    {0, 0}, // transformation
+};
+
+// Indices into clips, sorted by folder and track.
+inline constexpr uint16_t by_id[] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+    21, 22, 23, 24, 25,
+};
+
+} // namespace sound_manifest
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dotmatrix.h"
+#include "sound_manifest.h"
+
+// Sprites for the dot matrix, drawn as ASCII art ('#' is a lit pixel) and
+// converted at compile time.
+
+namespace sprites {
+
+constexpr auto row(const char *art) -> uint32_t {
+  uint32_t bits = 0;
+  for (int x = 0; art[x] && x < 32; ++x) {
+    if (art[x] == '#')
+      bits |= 1u << x;
+  }
+  return bits;
+}
+
+inline constexpr uint32_t ball_rows[] = {
+    row("##"),
+    row("##"),
+};
+inline constexpr Sprite ball = {2, 2, ball_rows};
+
+// One icon per sound category (see sound_manifest.h).
+
+inline constexpr uint32_t bell_rows[] = {
+    row("...##..."), row("..####.."), row(".######."), row(".######."),
+    row(".######."), row("########"), row("........"), row("...##..."),
+};
+inline constexpr uint32_t note_rows[] = {
+    row("...####."), row("...#..#."), row("...#..#."), row("...#..#."),
+    row(".###.###"), row("########"), row("###..###"), row("........"),
+};
+inline constexpr uint32_t jump_rows[] = {
+    row("...##..."), row("...##..."), row(".######."), row("#..##..#"),
+    row("...##..."), row("..#..#.."), row(".#....#."), row("#......#"),
+};
+inline constexpr uint32_t bolt_rows[] = {
+    row("....###."), row("...###.."), row("..###..."), row(".######."),
+    row("...###.."), row("..###..."), row(".##....."), row("#......."),
+};
+inline constexpr uint32_t coin_rows[] = {
+    row("..####.."), row(".#....#."), row("#..##..#"), row("#.#....#"),
+    row("#..##..#"), row("#....#.#"), row(".#.##.#."), row("..####.."),
+};
+inline constexpr uint32_t explosion_rows[] = {
+    row("#..#..#."), row(".#.#.#.."), row("..###..."), row("###.####"),
+    row("..###..."), row(".#.#.#.."), row("#..#..#."), row("...#...#"),
+};
+inline constexpr uint32_t sweep_rows[] = {
+    row(".......#"), row("......#."), row(".....#.."), row("....#..."),
+    row("...#...."), row("..#....."), row(".#......"), row("########"),
+};
+inline constexpr uint32_t swirl_rows[] = {
+    row("..####.."), row(".#....#."), row("#..##..#"), row("#.#..#.#"),
+    row("#.#.##.#"), row("#.#....#"), row(".#....#."), row("..####.."),
+};
+
+inline constexpr Sprite bell = {8, 8, bell_rows};
+inline constexpr Sprite note = {8, 8, note_rows};
+inline constexpr Sprite jump = {8, 8, jump_rows};
+inline constexpr Sprite bolt = {8, 8, bolt_rows};
+inline constexpr Sprite coin = {8, 8, coin_rows};
+inline constexpr Sprite explosion = {8, 8, explosion_rows};
+inline constexpr Sprite sweep = {8, 8, sweep_rows};
+inline constexpr Sprite swirl = {8, 8, swirl_rows};
+
+constexpr auto category_icon(SoundCategory category) -> Sprite const & {
+  switch (category) {
+  case SoundCategory::phone:
+  case SoundCategory::alarms_rings_and_sirens:
+    return bell;
+  case SoundCategory::names:
+  case SoundCategory::blips_and_beeps:
+    return note;
+  case SoundCategory::movement_jump_and_drop:
+    return jump;
+  case SoundCategory::noise_and_engine:
+    return bolt;
+  case SoundCategory::score_sounds:
+    return coin;
+  case SoundCategory::shots_and_explosions:
+    return explosion;
+  case SoundCategory::sweeps:
+    return sweep;
+  default:
+    return swirl;
+  }
+}
+
+} // namespace sprites
@@ -0,0 +1,168 @@
+#include "timer_wheel.h"
+
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+
+#define TIMER_WHEEL_SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELTA                                                  \
+  ((1u << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1)
+
+TimerWheel timers;
+
+namespace {
+void timer_wheel_alarm(uint alarm_num) { timers.on_alarm(); }
+} // namespace
+
+auto TimerWheel::init() -> void {
+  alarm_num_ = hardware_alarm_claim_unused(true);
+  hardware_alarm_set_callback(alarm_num_, timer_wheel_alarm);
+  tick_us_ = time_us_64();
+}
+
+auto TimerWheel::schedule(Timer &timer, uint32_t ms) -> void {
+  auto const irq = save_and_disable_interrupts();
+  if (timer.pending()) {
+    remove(timer);
+    pending_--;
+  }
+  uint32_t elapsed = elapsed_ticks();
+  if (pending_ == 0 && !in_alarm_) {
+    // Nothing to cascade or fire, the wheel can skip ahead.
+    now_ = now_ + elapsed;
+    tick_us_ += static_cast<uint64_t>(elapsed) * TIMER_WHEEL_TICK_US;
+    elapsed = 0;
+  }
+  // The current tick started up to a tick ago.
+  timer.expires_ = now_ + elapsed + ms + 1;
+  add(timer);
+  pending_++;
+  // on_alarm() rearms once it has caught up.
+  if (!in_alarm_ && rearm())
+    hardware_alarm_force_irq(alarm_num_);
+  restore_interrupts(irq);
+}
+
+auto TimerWheel::cancel(Timer &timer) -> void {
+  auto const irq = save_and_disable_interrupts();
+  if (timer.pending()) {
+    remove(timer);
+    pending_--;
+  }
+  restore_interrupts(irq);
+}
+
+auto TimerWheel::add(Timer &timer) -> void {
+  uint32_t delta = timer.expires_ - now_;
+  if (delta > TIMER_WHEEL_MAX_DELTA) {
+    delta = TIMER_WHEEL_MAX_DELTA;
+    timer.expires_ = now_ + delta;
+  }
+
+  // Pick the lowest level whose range covers the deadline.
+  uint8_t level = 0;
+  while (delta >= (1u << ((level + 1) * TIMER_WHEEL_SLOT_BITS)))
+    ++level;
+  auto const slot =
+      (timer.expires_ >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+
+  Timer **head = &slots_[level][slot];
+  if (level == 0)
+    level0_used_ |= 1ull << slot;
+  timer.next_ = *head;
+  if (timer.next_)
+    timer.next_->pprev_ = &timer.next_;
+  timer.pprev_ = head;
+  *head = &timer;
+}
+
+auto TimerWheel::remove(Timer &timer) -> void {
+  // A level 0 slot is empty once its only timer is gone.
+  Timer **const level0 = slots_[0];
+  if (!timer.next_ && timer.pprev_ >= level0 &&
+      timer.pprev_ < level0 + TIMER_WHEEL_SLOTS)
+    level0_used_ &= ~(1ull << (timer.pprev_ - level0));
+  *timer.pprev_ = timer.next_;
+  if (timer.next_)
+    timer.next_->pprev_ = timer.pprev_;
+  timer.next_ = nullptr;
+  timer.pprev_ = nullptr;
+}
+
+// Moves all timers of the current slot on `level` one level down.
+auto TimerWheel::cascade(uint8_t level) -> void {
+  auto const slot =
+      (now_ >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+  Timer *t = slots_[level][slot];
+  slots_[level][slot] = nullptr;
+  while (t) {
+    Timer *next = t->next_;
+    t->pprev_ = nullptr;
+    add(*t);
+    t = next;
+  }
+}
+
+auto TimerWheel::tick() -> void {
+  now_ = now_ + 1;
+
+  auto const slot = now_ & TIMER_WHEEL_SLOT_MASK;
+  if (slot == 0) {
+    if (((now_ >> TIMER_WHEEL_SLOT_BITS) & TIMER_WHEEL_SLOT_MASK) == 0)
+      cascade(2);
+    cascade(1);
+  }
+
+  // Every timer on this level 0 slot expires right now.
+  while (Timer *t = slots_[0][slot]) {
+    remove(*t);
+    pending_--;
+    uint32_t const again_ms = t->callback_(t->user_data_);
+    if (again_ms > 0 && !t->pending()) {
+      t->expires_ = now_ + again_ms;
+      add(*t);
+      pending_++;
+    }
+  }
+}
+
+auto TimerWheel::elapsed_ticks() const -> uint32_t {
+  return (time_us_64() - tick_us_) / TIMER_WHEEL_TICK_US;
+}
+
+// Ticks from now_ to the next one with work: a level 0 slot with timers,
+// or the cascade at the end of level 0.
+auto TimerWheel::next_event() const -> uint32_t {
+  uint32_t const slot = now_ & TIMER_WHEEL_SLOT_MASK;
+  uint32_t const to_cascade = TIMER_WHEEL_SLOTS - slot;
+  if (to_cascade > 1) {
+    uint64_t const later = level0_used_ >> (slot + 1);
+    if (later)
+      return __builtin_ctzll(later) + 1;
+  }
+  return to_cascade;
+}
+
+// Sets the alarm to the next event, or stops it if no timer is pending.
+// Returns true if that event is already due.
+auto TimerWheel::rearm() -> bool {
+  if (pending_ == 0) {
+    hardware_alarm_cancel(alarm_num_);
+    return false;
+  }
+  uint64_t const target =
+      tick_us_ + static_cast<uint64_t>(next_event()) * TIMER_WHEEL_TICK_US;
+  return hardware_alarm_set_target(alarm_num_, from_us_since_boot(target));
+}
+
+auto TimerWheel::on_alarm() -> void {
+  in_alarm_ = true;
+  do {
+    // All ticks up to now; the skipped ones have nothing to do, and there
+    // are more if interrupts were blocked for a while.
+    for (uint32_t n = elapsed_ticks(); n > 0; --n) {
+      tick_us_ += TIMER_WHEEL_TICK_US;
+      tick();
+    }
+  } while (rearm());
+  in_alarm_ = false;
+}
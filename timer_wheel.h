@@ -0,0 +1,95 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+// A hierarchical timer wheel driven by a single hardware alarm.
+//
+// All software timeouts (debounce windows, the frame tick, LED retain times,
+// ...) are multiplexed onto one hardware alarm with a resolution of
+// TIMER_WHEEL_TICK_US. Timers are intrusive list nodes, so scheduling and
+// cancelling are O(1) and never allocate.
+//
+// The alarm only fires for ticks with work: a level 0 slot with timers, or
+// the cascade at the end of level 0 (every 64 ticks). It is stopped while
+// no timer is pending.
+//
+// There are three levels of 64 slots each:
+//   level 0: 1 tick per slot      -> timeouts up to 64 ms
+//   level 1: 64 ticks per slot    -> timeouts up to 4.096 s
+//   level 2: 4096 ticks per slot  -> timeouts up to ~262 s
+// Timers on the higher levels are cascaded down when their slot comes up.
+// Longer timeouts are clamped to the maximum.
+//
+// Callbacks run in interrupt context. A callback returns the number of ms
+// after which it wants to run again, or 0 for a one-shot timer.
+
+#define TIMER_WHEEL_TICK_US 1000
+#define TIMER_WHEEL_LEVELS 3
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+static_assert(TIMER_WHEEL_SLOTS == 64, "level0_used_ has a bit per slot");
+
+class TimerWheel {
+public:
+  using Callback = uint32_t (*)(void *user_data);
+
+  class Timer {
+  public:
+    Timer(Callback callback, void *user_data)
+        : callback_(callback), user_data_(user_data) {}
+    Timer(Timer const &) = delete;
+    Timer &operator=(Timer const &) = delete;
+
+    bool pending() const { return pprev_ != nullptr; }
+
+  private:
+    friend class TimerWheel;
+    Callback callback_;
+    void *user_data_;
+    uint32_t expires_ = 0;
+    Timer *next_ = nullptr;
+    // Points to the `next_` field of the previous node (or the slot head).
+    // nullptr means the timer is not scheduled.
+    Timer **pprev_ = nullptr;
+  };
+
+  TimerWheel() = default;
+
+  // Claims a hardware alarm, which runs once a timer is scheduled.
+  auto init() -> void;
+
+  // (Re)schedules `timer` to fire in `ms` milliseconds: never earlier, at
+  // most one tick later. If the timer is already pending, it is moved to
+  // the new deadline.
+  auto schedule(Timer &timer, uint32_t ms) -> void;
+
+  // Cancels a pending timer. Cancelling an idle timer is a no-op.
+  auto cancel(Timer &timer) -> void;
+
+  // Called from the hardware alarm interrupt.
+  auto on_alarm() -> void;
+
+private:
+  auto add(Timer &timer) -> void;
+  auto remove(Timer &timer) -> void;
+  auto cascade(uint8_t level) -> void;
+  auto tick() -> void;
+  auto elapsed_ticks() const -> uint32_t;
+  auto next_event() const -> uint32_t;
+  auto rearm() -> bool;
+
+  int alarm_num_ = -1;
+  // The time of tick now_. The wheel is not advanced between events, so
+  // the current tick is usually later.
+  uint64_t tick_us_ = 0;
+  volatile uint32_t now_ = 0;
+  uint32_t pending_ = 0;
+  // Set while on_alarm() catches up, the wheel must not skip ahead then.
+  bool in_alarm_ = false;
+  Timer *slots_[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS] = {};
+  // Bit i is set if level 0 slot i has timers.
+  uint64_t level0_used_ = 0;
+};
+
+extern TimerWheel timers;
@@ -2,19 +2,33 @@
 
 #include "hardware/gpio.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
 #include "pico/stdlib.h"
 #include <cmath>
 #include <cstdint>
-#include <iostream>
+
+#include "motion_profile.h"
+#include "vid28_microsteps.h"
 
 namespace detail {
-extern uint8_t microsteps_sine_[24];
-extern uint16_t accel_table_[32];
-constexpr int microstep_wait_usec_begin_ = 1 * 2400;
-constexpr float accel_ = 0.95;
-constexpr uint8_t accel_rampup_ = 2;
+// There are 24 microsteps for a full rotation of the motor.
+constexpr uint8_t microsteps_ = 24;
+// vid28::pin_levels (generate-microstep-table.py) has this many entries
+// per microstep. They are spread over the time of the microstep, so the
+// coil currents change in small steps even when the needle moves slowly.
+constexpr uint8_t substeps_ = VID28_TABLE_SIZE / microsteps_;
+static_assert(VID28_TABLE_SIZE % microsteps_ == 0);
 } // namespace detail
 
+enum class Vid28Status : uint8_t { Idle, Moving };
+
+// Drives a VID28-05 gauge stepper from three PWM pins.
+//
+// Moves run in the background: step_to() and reset() only set the target,
+// the microsteps are done from a hardware alarm interrupt, one substep per
+// alarm, and timed by motion_profile.h. The target can be changed while the
+// needle moves; it then follows without stopping first.
 template <uint8_t PIN_1, uint8_t PIN_2_3, uint8_t PIN_4> class Vid28Stepper {
 public:
   Vid28Stepper() = default;
@@ -27,63 +41,83 @@ public:
       pwm_slices_[i] = pwm_gpio_to_slice_num(pin);
       pwm_channels_[i] = pwm_gpio_to_channel(pin);
       pwm_config config = pwm_get_default_config();
-      pwm_config_set_wrap(&config, 127);
+      pwm_config_set_wrap(&config, VID28_PWM_WRAP);
       pwm_init(pwm_slices_[i], &config, true);
     }
 
-    detail::accel_table_[0] = detail::microstep_wait_usec_begin_;
-    for (auto i = 1; i < 32; ++i) {
-      detail::accel_table_[i] =
-          detail::accel_ * static_cast<float>(detail::accel_table_[i - 1]);
-    }
-
-    std::cout << "ACCEL TABLE" << std::endl;
-    for (auto i = 0; i < 32; ++i) {
-      std::cout << "[" << i << "] = " << detail::accel_table_[i] << std::endl;
-    }
+    instance_ = this;
+    alarm_num_ = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(alarm_num_, on_alarm);
   }
 
+  // Turns a full revolution against the end stop; the needle is at angle 0
+  // once status() is Idle again.
   void reset(int direction, float hz) {
-    bool forward = (direction > 0) ? true : false;
-    step_micros(360 * 12, hz, forward);
-    current_angle_ = 0;
+    int32_t const to_go = (direction > 0) ? 360 * 12 : -360 * 12;
+    move(current_angle_ + to_go, hz, true);
   }
 
   void set_zero(float degrees) { zero_angle_ = std::round(degrees * 12); }
 
+  // `hz` is the top speed in revolutions per second.
   void step_to(float degrees, float hz) {
-    int32_t to_go = std::round(degrees * 12) - (current_angle_ - zero_angle_);
-    bool forward = (to_go > 0) ? true : false;
-    step_micros(std::abs(to_go), hz, forward);
-    current_angle_ += to_go;
-    std::cout << "step_to went to angle = " << current_angle_ / 12.0
-              << std::endl;
+    move(std::round(degrees * 12) + zero_angle_, hz, false);
   }
 
+  void set_profile(motion::Profile profile) { profile_ = profile; }
+
+  // Needle angle in degrees relative to set_zero(), updated every microstep.
+  float angle() const { return (current_angle_ - zero_angle_) / 12.0f; }
+  Vid28Status status() const { return status_; }
+  bool moving() const { return status_ == Vid28Status::Moving; }
+
 private:
-  auto step_micros(uint microstep_count, float hz, bool forward) {
-    uint64_t us_per_microstep = 1.0 / (hz * 1.0E-6 * 360 * 12);
-    std::cout << "I will wait " << us_per_microstep << " us between steps"
-              << std::endl;
-    uint16_t wait_us;
-    for (auto s = 0; s < microstep_count; ++s) {
-      if (s < 2 * detail::accel_rampup_ * 32) {
-        wait_us = detail::microstep_wait_usec_begin_;
-      } else if (s < detail::accel_rampup_ * 32) {
-        wait_us = detail::accel_table_[s / detail::accel_rampup_];
-        // std::cout << wait_us << " rampup " << std::endl;
-      } else if (s >= microstep_count - detail::accel_rampup_ * 32) {
-        wait_us = detail::accel_table_[31 - (microstep_count - s) /
-                                                detail::accel_rampup_];
-        // std::cout << wait_us << " rampdown " << std::endl;
-      } else {
-        wait_us = detail::accel_table_[31];
-      }
-      microstep(forward);
-      sleep_us(wait_us);
-      sleep_ms(1);
+  void move(int32_t target, float hz, bool zero_when_done) {
+    uint16_t const max_level =
+        motion::max_level(profile_, std::lround(hz * 360 * 12));
+    auto const irq = save_and_disable_interrupts();
+    target_ = target;
+    max_level_ = max_level;
+    zero_when_done_ = zero_when_done;
+    if (status_ == Vid28Status::Idle) {
+      status_ = Vid28Status::Moving;
+      next_us_ = time_us_64();
+      // The first microstep is due now.
+      if (hardware_alarm_set_target(alarm_num_,
+                                    from_us_since_boot(next_us_)))
+        advance();
     }
-    // stop();
+    restore_interrupts(irq);
+  }
+
+  static void on_alarm(uint alarm_num) { instance_->advance(); }
+
+  void advance() {
+    // A target in the past fires right away, so a late interrupt catches
+    // up without dropping microsteps.
+    do {
+      if (substeps_left_ == 0) {
+        int8_t const step =
+            motion::advance(target_ - current_angle_, motion_, max_level_);
+        if (step == 0) {
+          if (zero_when_done_) {
+            current_angle_ = 0;
+            target_ = 0;
+          }
+          status_ = Vid28Status::Idle;
+          return;
+        }
+        current_angle_ += step;
+        forward_ = step > 0;
+        substeps_left_ = detail::substeps_;
+        substep_us_ =
+            motion::interval_us(profile_, motion_.level) / detail::substeps_;
+      }
+      substep(forward_);
+      substeps_left_--;
+      next_us_ += substep_us_;
+    } while (
+        hardware_alarm_set_target(alarm_num_, from_us_since_boot(next_us_)));
   }
 
   void stop() {
@@ -92,31 +126,40 @@ private:
     pwm_set_gpio_level(PIN_4, 0);
   }
 
-  // One microstep moves 1/12 degree
-  void microstep(bool forward) {
+  // One microstep (1/12 degree) is detail::substeps_ substeps.
+  void substep(bool forward) {
     constexpr uint8_t pins[3] = {PIN_1, PIN_2_3, PIN_4};
+    if (forward)
+      phase_ = (phase_ + 1) % VID28_TABLE_SIZE;
+    else
+      phase_ = (phase_ == 0 ? VID28_TABLE_SIZE : phase_) - 1;
     for (uint8_t i = 0; i < 3; ++i) {
-      uint8_t const level = detail::microsteps_sine_[current_microstep_[i]];
-
-      if (forward)
-        current_microstep_[i] = (current_microstep_[i] + 1) % 24;
-      else {
-        if (current_microstep_[i] == 0)
-          current_microstep_[i] = 23;
-        else
-          --current_microstep_[i];
-      }
-      pwm_set_gpio_level(pins[i], level);
+      pwm_set_gpio_level(pins[i], vid28::pin_levels[i][phase_]);
     }
   }
 
-  // There are 24 microsteps for a full rotation of the motor.
-  // Phase difference of the three sine waves is 120 deg or 24/3 = 8.
-  int8_t current_microstep_[3] = {0, 8, 16};
+  static inline Vid28Stepper *instance_ = nullptr;
+  int alarm_num_ = -1;
+
+  // Index into vid28::pin_levels.
+  uint8_t phase_ = 0;
   int8_t pwm_slices_[3];
   int8_t pwm_channels_[3];
 
   // Current angle in 1/12 degrees
-  int32_t current_angle_ = 0;
+  volatile int32_t current_angle_ = 0;
   int32_t zero_angle_ = 0;
+
+  // Set by move(), followed by the alarm interrupt.
+  volatile int32_t target_ = 0;
+  volatile uint16_t max_level_ = 0;
+  volatile bool zero_when_done_ = false;
+  motion::Profile profile_ = motion::Profile::SCurve;
+
+  motion::State motion_;
+  bool forward_ = true;
+  uint8_t substeps_left_ = 0;
+  uint16_t substep_us_ = 0;
+  uint64_t next_us_ = 0;
+  volatile Vid28Status status_ = Vid28Status::Idle;
 };